@@ -0,0 +1,62 @@
+#ifndef BIN_INDEX_H
+#define BIN_INDEX_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "../src/bin.h"
+
+// Box dimensions in ascending order; a box fits another in some orientation
+// only if each of its sorted dimensions is no larger
+std::array<long, 3> sortedDimensions(const Box& box);
+
+// The bins of a packer ordered by volume, then by position, with their sorted
+// dimensions. Finding the smallest bin an item may fit in is a binary search
+// on volume followed by a walk over cheap dimension checks.
+class BinIndex {
+public:
+    BinIndex();
+
+    void build(const std::vector<Bin>& bins);
+
+    // False once bins were added or removed since build(). Reordering bins or
+    // resizing them in place goes unnoticed, so build() again after that.
+    bool matches(const std::vector<Bin>& bins) const;
+
+    // Visit positions in `bins` of bins holding at least `min_volume` (more than
+    // it when `strictly_bigger`) whose sorted dimensions can hold `dims`,
+    // smallest first; stops when visit returns true
+    template <typename Visitor>
+    bool forEachCandidate(long min_volume, bool strictly_bigger, const std::array<long, 3>& dims, Visitor&& visit) const;
+
+private:
+    struct Entry {
+        long volume;
+        std::array<long, 3> dims;
+        std::size_t position;
+    };
+
+    std::vector<Entry> entries;
+    const Bin* indexed_data;
+    std::size_t indexed_size;
+};
+
+template <typename Visitor>
+bool BinIndex::forEachCandidate(long min_volume, bool strictly_bigger, const std::array<long, 3>& dims, Visitor&& visit) const {
+    auto first = strictly_bigger
+        ? std::upper_bound(entries.begin(), entries.end(), min_volume,
+                           [](long volume, const Entry& entry) { return volume < entry.volume; })
+        : std::lower_bound(entries.begin(), entries.end(), min_volume,
+                           [](const Entry& entry, long volume) { return entry.volume < volume; });
+    for (auto it = first; it != entries.end(); ++it) {
+        if (it->dims[0] < dims[0] || it->dims[1] < dims[1] || it->dims[2] < dims[2]) {
+            continue;
+        }
+        if (visit(it->position)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // BIN_INDEX_H
@@ -1,6 +1,7 @@
 #ifndef BOX_H
 #define BOX_H
 
+#include <cstddef>
 #include <string>
 
 class Box {
@@ -11,6 +12,8 @@ public:
     long width;
     long height;
     long depth;
+    // Position in the caller's input list, so batch results can point back to it
+    std::size_t input_index = 0;
     std::string getName() const;
     long getWidth() const;
     long getHeight() const;
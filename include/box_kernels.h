@@ -0,0 +1,24 @@
+#ifndef BOX_KERNELS_H
+#define BOX_KERNELS_H
+
+#include <array>
+#include <cstdint>
+#include "placed_boxes.h"
+
+// Batched integer box tests over PlacedBoxes. Every kernel has a scalar
+// version and, on x86-64 builds with GCC or Clang, an AVX2 version that is
+// picked on first use when the CPU supports it.
+
+// First placed box in [begin, end) overlapping `box`, or `end` if none does
+std::size_t firstOverlap(const PlacedBoxes& boxes, std::size_t begin, std::size_t end, const GridBox& box);
+
+// For each of `count` positions, bit k of masks[i] is set when a box of size
+// dimensions[k] anchored at positions[i] stays inside `extent`; at most 8 sizes
+void boundsFitMasks(const std::array<long, 3>* positions, std::size_t count,
+                    const std::array<long, 3>* dimensions, std::size_t dimension_count,
+                    const std::array<long, 3>& extent, uint8_t* masks);
+
+// True when the kernels above run on AVX2 in this process
+bool boxKernelsUseAvx2();
+
+#endif // BOX_KERNELS_H
@@ -0,0 +1,65 @@
+#ifndef BRKGA_H
+#define BRKGA_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "packer.h"
+#include "portfolio.h"
+
+// One line of the convergence log, written after each generation is decoded
+struct BrkgaGeneration {
+    std::size_t generation;  // 0 for the first population
+    double best_packed_volume;
+    std::size_t best_bins_used;
+    double mean_packed_volume;  // over the whole population
+    std::chrono::milliseconds elapsed;
+};
+
+struct BrkgaOptions {
+    std::size_t population = 64;
+    // Shares of the population kept as elites and replaced by random mutants
+    // each generation; the rest are children of an elite and a non-elite
+    double elite_fraction = 0.2;
+    double mutant_fraction = 0.15;
+    // Chance a child takes each key from its elite parent
+    double elite_bias = 0.7;
+    std::size_t generations = 200;
+    // Give up after this many generations in a row without a better best; 0 never
+    std::size_t max_stall_generations = 50;
+    // Wall-clock budget for the whole search; the packer's own deadline and
+    // cancel token stop it too
+    std::chrono::milliseconds budget{10000};
+    std::size_t threads = std::thread::hardware_concurrency();
+    uint32_t seed = 0;
+    PortfolioObjective objective = PortfolioObjective::PACKED_VOLUME;
+    // Start from the default volume order as one member of the first population
+    bool seed_with_greedy = true;
+    // Called on the calling thread after every generation
+    std::function<void(const BrkgaGeneration&)> on_generation;
+};
+
+struct BrkgaResult {
+    std::size_t generations = 0;  // evolved after the first population
+    std::size_t decoded = 0;      // chromosomes packed
+    double packed_volume = 0;
+    std::size_t bins_used = 0;
+    std::vector<double> best_keys;  // chromosome of the solution left in the packer
+    std::vector<BrkgaGeneration> log;
+};
+
+// Biased random-key genetic search over packing orders. A chromosome holds
+// two keys in [0, 1) per item: items are packed by packRanked() in ascending
+// order of their first key, and a second key of 0.5 or more pins the item to
+// one of its allowed rotations instead of the one the bin would pick. Every
+// worker decodes on its own packer, emptied before each decode. The best
+// decode is kept as the search goes and left in `packer`, so the search
+// returns at its deadline or cancellation; ties go to the earlier member of
+// a generation, so the result only depends on the options as long as the
+// budget does not run out.
+BrkgaResult packBrkga(Packer& packer, const BrkgaOptions& options = {});
+
+#endif // BRKGA_H
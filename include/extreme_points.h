@@ -0,0 +1,120 @@
+#ifndef EXTREME_POINTS_H
+#define EXTREME_POINTS_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "spatial_grid.h"
+
+// Candidate anchor points for the next placement in a bin. Every landed box
+// contributes the corners on its +width, +height and +depth faces; duplicates
+// are merged and points that fall inside a placed box are dropped.
+//
+// Points are kept in a binary heap ordered by distance to the origin
+// (x + y + z, then height, depth, width). Each push is journaled so the latest
+// landing can be undone with pop() without rebuilding the set.
+class ExtremePointSet {
+public:
+    using Point = std::array<long, 3>;
+
+    ExtremePointSet();
+
+    // Forget every landing; only the origin remains
+    void clear();
+
+    // Record that `box` (grid id `id`) landed in a bin of the given extent.
+    // Coverage of the new anchors is only tested against ids up to `id`.
+    void push(const GridBox& box, uint32_t id, const SpatialGrid& grid, const Point& extent);
+
+    // Undo the latest push
+    void pop();
+
+    // Drop a point nothing more will be anchored at. Not journaled: pop()
+    // leaves it dropped unless the push it undoes had covered it.
+    void retire(const Point& point);
+
+    // Record that a cube of this edge anchored at the point overlaps a placed
+    // box, so nothing with every edge at least that long fits there. Not
+    // journaled either; revived points start unblocked.
+    void block(const Point& point, long edge);
+
+    std::size_t depth() const;
+    std::size_t size() const;
+
+    // Visit live points nearest first; stops when visit returns true. Points
+    // blocked for cubes of edge `shortest_edge` or less are skipped.
+    template <typename Visitor>
+    bool forEachInOrder(Visitor&& visit, long shortest_edge = 0) const;
+
+private:
+    struct Entry {
+        Point point;
+        long distance;
+        long blocked_edge;
+        uint32_t live_slot;  // position in `live` while alive
+        bool alive;
+        bool in_heap;
+    };
+
+    struct PointHash {
+        std::size_t operator()(const Point& p) const;
+    };
+
+    struct JournalEntry {
+        uint32_t first_change;
+        uint32_t added;
+        uint32_t killed;
+    };
+
+    bool before(uint32_t a, uint32_t b) const;
+    void heapPush(uint32_t index);
+    void compact();
+    bool revive(const Point& point);
+    void makeLive(uint32_t index);
+    void kill(uint32_t index);
+
+    std::vector<Entry> entries;
+    std::unordered_map<Point, uint32_t, PointHash> lookup;
+    // Ids of the live entries, unordered, so a push scans only those
+    std::vector<uint32_t> live;
+    std::vector<uint32_t> heap;
+    std::size_t stale_in_heap;
+
+    std::vector<JournalEntry> journal;
+    std::vector<uint32_t> changes;  // per entry: revived ids, then killed ids
+
+    // Frontier of heap slots used while walking the heap in order
+    mutable std::vector<uint32_t> frontier;
+};
+
+template <typename Visitor>
+bool ExtremePointSet::forEachInOrder(Visitor&& visit, long shortest_edge) const {
+    // Walk the heap lazily: the smallest unvisited entry is always a child of
+    // one already visited, so only the part of the heap we consume is sorted
+    auto slot_before = [this](uint32_t a, uint32_t b) { return before(heap[b], heap[a]); };
+
+    frontier.clear();
+    if (!heap.empty()) {
+        frontier.push_back(0);
+    }
+    while (!frontier.empty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), slot_before);
+        uint32_t slot = frontier.back();
+        frontier.pop_back();
+
+        for (uint32_t child = 2 * slot + 1; child <= 2 * slot + 2 && child < heap.size(); ++child) {
+            frontier.push_back(child);
+            std::push_heap(frontier.begin(), frontier.end(), slot_before);
+        }
+
+        const Entry& entry = entries[heap[slot]];
+        if (entry.alive && entry.blocked_edge > shortest_edge && visit(entry.point)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // EXTREME_POINTS_H
@@ -0,0 +1,53 @@
+#ifndef HEIGHT_MAP_H
+#define HEIGHT_MAP_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "spatial_grid.h"
+
+// Top of the load over a bin's width x depth floor, in square cells of a
+// fixed size. A landed box raises every cell its base touches to its top,
+// so a cell the box only partly covers counts as covered: queries are exact
+// with a cell size of 1 and otherwise off by at most a cell along box edges.
+//
+// Each push is journaled so the latest landing can be undone with pop().
+class HeightMap {
+public:
+    HeightMap();
+
+    // Flat, empty floor of the given size
+    void reset(long width, long depth, long cell);
+    // Whether the map was reset for this floor and cell size
+    bool covers(long width, long depth, long cell) const;
+
+    // Record that `box` landed
+    void push(const GridBox& box);
+
+    // Undo the latest push
+    void pop();
+
+    std::size_t depth() const;
+
+    // Height at which a w x d base at (x, z) comes to rest when lowered from above
+    long restingHeight(long x, long z, long w, long d) const;
+
+    // Share of a w x d base at (x, y, z) lying on cells whose top is y
+    double supportedFraction(long x, long y, long z, long w, long d) const;
+
+private:
+    // Cells [first, last] touched by the span [from, from + length) on one axis
+    std::pair<long, long> cellRange(long from, long length, long columns_or_rows) const;
+
+    long floor_width;
+    long floor_depth;
+    long cell;
+    long columns;
+    long rows;
+    std::vector<long> tops;  // row by row along depth, `columns` cells each
+
+    std::vector<std::pair<uint32_t, long>> undo;  // cell and its top before a push
+    std::vector<uint32_t> journal;                // size of `undo` before each push
+};
+
+#endif // HEIGHT_MAP_H
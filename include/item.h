@@ -1,10 +1,13 @@
 // item.h
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 #include <map>
 #include <ostream>
+#include <tuple>
+#include <type_traits>
 #include "box.h"
 
 enum class RotationType {
@@ -45,6 +48,50 @@ inline size_t axisToIndex(Axis axis) {
     }
 }
 
+constexpr std::size_t ROTATION_COUNT = 6;
+
+// type_id of items added one by one rather than through Packer::addItemType
+constexpr std::size_t NO_ITEM_TYPE = static_cast<std::size_t>(-1);
+
+// For each RotationType, the unrotated axis (0 width, 1 height, 2 depth)
+// that ends up along width, height and depth
+constexpr std::array<std::array<std::size_t, 3>, ROTATION_COUNT> ROTATION_AXES = {{
+    {0, 1, 2},  // whd
+    {1, 0, 2},  // hwd
+    {1, 2, 0},  // hdw
+    {2, 1, 0},  // dhw
+    {2, 0, 1},  // dwh
+    {0, 2, 1}   // wdh
+}};
+
+// (width, height, depth) of a w x h x d box once turned to the given rotation
+constexpr std::array<long, 3> rotateDimension(long w, long h, long d, RotationType rotation) {
+    const std::array<long, 3> source = {w, h, d};
+    std::size_t index = static_cast<std::size_t>(rotation);
+    const auto& axes = ROTATION_AXES[index < ROTATION_COUNT ? index : 0];
+    return {source[axes[0]], source[axes[1]], source[axes[2]]};
+}
+
+static_assert(rotateDimension(1, 2, 3, RotationType::dwh)[0] == 3 &&
+              rotateDimension(1, 2, 3, RotationType::dwh)[1] == 1 &&
+              rotateDimension(1, 2, 3, RotationType::dwh)[2] == 2,
+              "ROTATION_AXES follows the RotationType names");
+
+// Compact, trivially copyable pose of an item: what the placement hot paths
+// read. Filling one never touches the heap, unlike copying an Item.
+struct ItemGeometry {
+    std::array<long, 3> dimension;  // after rotation
+    std::array<long, 3> position;
+    RotationType rotation;
+    float weight;
+
+    // True if the two boxes share interior volume
+    bool intersects(const ItemGeometry& other) const;
+};
+
+static_assert(std::is_trivially_copyable<ItemGeometry>::value,
+              "ItemGeometry is copied freely in the placement loops");
+
 class Item : public Box {
 public:
     // Updated constructor with stuffing parameters and new constraints
@@ -66,6 +113,10 @@ public:
 
     std::string getRotationTypeString() const;
     std::vector<long> getDimension() const;
+
+    // Current pose, or the pose the item would have with another rotation and position
+    ItemGeometry getGeometry() const;
+    ItemGeometry getGeometry(RotationType rotation, const std::tuple<long, long, long>& position) const;
     std::vector<long> getPos() const;
 
     bool doesIntersect(const Item& other) const;
@@ -102,6 +153,7 @@ public:
     int _stuffing_layers;           // Number of stuffing layers
     float _stuffing_max_weight;     // Maximum weight for stuffing
     long _stuffing_height;          // Stuffing height in mm
+    std::size_t type_id = NO_ITEM_TYPE;  // SKU this item is a copy of
 
 private:
     bool height_constrained = false;
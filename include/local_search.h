@@ -0,0 +1,53 @@
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include "packer.h"
+#include "portfolio.h"
+
+// Neighbourhood moves of the improvement phase
+enum class MoveKind {
+    INSERT,    // an unfit item into a used bin
+    SWAP,      // a placed item out for a larger unfit one, then back in wherever it fits
+    REORIENT,  // a placed item put back at its best pose, then an unfit item into the room left
+    RELOCATE,  // a placed item over to another used bin, then an unfit item into its bin
+    EMPTY_BIN  // every item of a used bin into the other used bins
+};
+
+struct ImproveOptions {
+    // Wall-clock budget for the whole phase; the packer's own deadline and
+    // cancel token stop it too
+    std::chrono::milliseconds budget{1000};
+    std::size_t threads = std::thread::hardware_concurrency();
+    // Moves sampled and evaluated in parallel per round
+    std::size_t moves_per_round = 64;
+    // Give up after this many rounds in a row without an improving move
+    std::size_t max_idle_rounds = 16;
+    uint32_t seed = 0;
+    PortfolioObjective objective = PortfolioObjective::PACKED_VOLUME;
+};
+
+struct ImproveResult {
+    std::size_t rounds = 0;
+    std::size_t evaluated = 0;  // moves tried
+    std::size_t accepted = 0;   // moves kept
+    double packed_volume_before = 0;
+    double packed_volume_after = 0;
+    std::size_t bins_used_before = 0;
+    std::size_t bins_used_after = 0;
+};
+
+// Improve a packed result in place by local search. Each round samples moves,
+// tries them in parallel on per-worker copies of the packer, and applies the
+// improving ones that touch different bins, best first. A move only removes
+// and re-places items through the packer's own placement, so stuffing,
+// stacking, weight and support limits hold throughout. Items on which other
+// items rest stay put while a minimum support ratio is set. Afterwards
+// `unfit_items` holds the items no bin holds, in `items` order. The result
+// only depends on the options as long as the budget does not run out.
+ImproveResult improvePacking(Packer& packer, const ImproveOptions& options = {});
+
+#endif // LOCAL_SEARCH_H
@@ -0,0 +1,175 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Least-recently-used map from keys to values, bounded in entries and in the
+// total weight of the values held. Every member takes the cache's lock, so
+// one cache can be shared between threads. `Index` maps keys to their place
+// in the recency list: std::unordered_map for hashable keys, std::map for
+// ordered ones.
+template <typename Key, typename Value, template <typename...> class Index = std::unordered_map>
+class LruCache {
+public:
+    using Weigh = std::function<std::size_t(const Value&)>;
+
+    // Without `weigh` values weigh nothing and only max_entries applies
+    explicit LruCache(std::size_t max_entries, std::size_t max_weight = std::numeric_limits<std::size_t>::max(),
+                      Weigh weigh = {});
+
+    // A copy of the key's value, which becomes the most recently used;
+    // counted as a hit or a miss
+    std::optional<Value> find(const Key& key);
+    // Store as the most recently used entry, evicting the least recent ones
+    // until both limits hold again. A value heavier than max_weight on its
+    // own would push out everything else and still not fit, so it is dropped.
+    void store(const Key& key, Value value);
+
+    std::size_t size() const;
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+protected:
+    // Call write(out, key, value) per entry, most recently used first; false
+    // if the file cannot be written
+    template <typename Write>
+    bool saveEntries(const std::string& path, Write write) const;
+    // Call read(in, key, value) until the file ends and store what it read;
+    // false if the file cannot be opened or read() fails, and then nothing
+    // is stored
+    template <typename Read>
+    bool loadEntries(const std::string& path, Read read);
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    void insert(const Key& key, Value value);
+
+    std::size_t max_entries;
+    std::size_t max_weight;
+    Weigh weigh;
+    std::size_t weight = 0;
+    std::list<Entry> entries;  // most recently used first
+    Index<Key, typename std::list<Entry>::iterator> index;
+    std::size_t hit_count = 0;
+    std::size_t miss_count = 0;
+    mutable std::mutex mutex;
+};
+
+template <typename Key, typename Value, template <typename...> class Index>
+LruCache<Key, Value, Index>::LruCache(std::size_t max_entries, std::size_t max_weight, Weigh weigh)
+    : max_entries(std::max<std::size_t>(1, max_entries)), max_weight(max_weight), weigh(std::move(weigh)) {}
+
+template <typename Key, typename Value, template <typename...> class Index>
+std::optional<Value> LruCache<Key, Value, Index>::find(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++miss_count;
+        return std::nullopt;
+    }
+    ++hit_count;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+void LruCache<Key, Value, Index>::store(const Key& key, Value value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    insert(key, std::move(value));
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+void LruCache<Key, Value, Index>::insert(const Key& key, Value value) {
+    const std::size_t value_weight = weigh ? weigh(value) : 0;
+    if (value_weight > max_weight) {
+        return;
+    }
+    auto it = index.find(key);
+    if (it != index.end()) {
+        weight -= weigh ? weigh(it->second->second) : 0;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    weight += value_weight;
+    entries.emplace_front(key, std::move(value));
+    index[key] = entries.begin();
+    while (entries.size() > max_entries || weight > max_weight) {
+        weight -= weigh ? weigh(entries.back().second) : 0;
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+std::size_t LruCache<Key, Value, Index>::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+std::size_t LruCache<Key, Value, Index>::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+std::size_t LruCache<Key, Value, Index>::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+template <typename Write>
+bool LruCache<Key, Value, Index>::saveEntries(const std::string& path, Write write) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [key, value] : entries) {
+        write(out, key, value);
+    }
+    return static_cast<bool>(out);
+}
+
+template <typename Key, typename Value, template <typename...> class Index>
+template <typename Read>
+bool LruCache<Key, Value, Index>::loadEntries(const std::string& path, Read read) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::vector<Entry> loaded;
+    while (!(in >> std::ws).eof()) {
+        Entry entry;
+        if (!read(in, entry.first, entry.second)) {
+            return false;
+        }
+        loaded.push_back(std::move(entry));
+    }
+
+    // The file lists the most recently used first, so insert it last
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = loaded.rbegin(); it != loaded.rend(); ++it) {
+        insert(it->first, std::move(it->second));
+    }
+    return true;
+}
+
+#endif // LRU_CACHE_H
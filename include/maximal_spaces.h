@@ -0,0 +1,90 @@
+#ifndef MAXIMAL_SPACES_H
+#define MAXIMAL_SPACES_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "spatial_grid.h"
+
+// Empty maximal spaces of a bin: the largest free cuboids, which may overlap
+// one another. Every landed box splits each space it cuts into the up to six
+// slabs left around it, and slabs lying inside another space are dropped.
+// A box fits somewhere in the bin exactly when it fits in one of the spaces.
+//
+// Each push is journaled so the latest landing can be undone with pop(),
+// which restores the list exactly as it was.
+class MaximalSpaceSet {
+public:
+    using Extent = std::array<long, 3>;
+
+    MaximalSpaceSet();
+
+    // Forget every landing; the whole bin of the given extent is free
+    void clear(const Extent& extent);
+
+    // Record that `box` landed
+    void push(const GridBox& box);
+
+    // Undo the latest push
+    void pop();
+
+    std::size_t depth() const;
+    std::size_t size() const;
+    const std::vector<GridBox>& spaces() const;
+
+    // The space whose min corner is nearest the origin among those that hold
+    // a box of this size; nothing without a scan if no space is long enough
+    // on some axis
+    std::optional<GridBox> best(const Extent& dimension) const;
+
+    // Visit every space that holds a box of this size
+    template <typename Visitor>
+    void forEachFitting(const Extent& dimension, Visitor&& visit) const;
+
+    // Order of anchors, as for extreme points: x + y + z, then height, depth, width
+    static bool nearer(const Extent& a, const Extent& b);
+
+private:
+    struct Removed {
+        uint32_t index;
+        GridBox space;
+    };
+
+    struct JournalEntry {
+        uint32_t first_removed;
+        uint32_t added;
+    };
+
+    bool holds(const GridBox& space, const Extent& dimension) const;
+    void updateLargest();
+
+    std::vector<GridBox> free_spaces;
+    std::vector<Removed> removed;  // spaces split by each push, by index before it
+    std::vector<JournalEntry> journal;
+    Extent largest;                // longest space on each axis
+
+    // Scratch buffers reused between pushes and pops
+    std::vector<GridBox> pieces;
+    std::vector<GridBox> merged;
+};
+
+inline bool MaximalSpaceSet::holds(const GridBox& space, const Extent& dimension) const {
+    return space.max[0] - space.min[0] >= dimension[0] &&
+           space.max[1] - space.min[1] >= dimension[1] &&
+           space.max[2] - space.min[2] >= dimension[2];
+}
+
+template <typename Visitor>
+void MaximalSpaceSet::forEachFitting(const Extent& dimension, Visitor&& visit) const {
+    if (largest[0] < dimension[0] || largest[1] < dimension[1] || largest[2] < dimension[2]) {
+        return;
+    }
+    for (const GridBox& space : free_spaces) {
+        if (holds(space, dimension)) {
+            visit(space);
+        }
+    }
+}
+
+#endif // MAXIMAL_SPACES_H
@@ -0,0 +1,58 @@
+#ifndef ORIENTATIONS_H
+#define ORIENTATIONS_H
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include "item.h"
+
+// Bin::scoreRotation for a rotated size: how snugly it fills a bin of the
+// given extent, or 0 when it does not fit
+float orientationScore(const std::array<long, 3>& dimension, const std::array<long, 3>& extent);
+
+// One distinct way to stand an item in a bin
+struct Orientation {
+    RotationType rotation;
+    std::array<long, 3> dimension;
+    float score;
+};
+
+// The distinct orientations an item type may take in a bin type. Rotations
+// giving the same size (any two for a cube) appear once, under the lowest
+// RotationType, which is also the one that wins a tie on score.
+struct OrientationTable {
+    std::array<Orientation, ROTATION_COUNT> orientations;
+    uint8_t count = 0;
+    uint8_t fitting = 0;                     // bit per allowed RotationType that fits the empty bin
+    RotationType best = RotationType::whd;   // Bin::getBestRotationOrder's pick
+
+    const Orientation* begin() const { return orientations.data(); }
+    const Orientation* end() const { return orientations.data() + count; }
+};
+
+OrientationTable buildOrientationTable(const Item& item, const std::array<long, 3>& extent);
+
+// Tables built so far for one bin, keyed by item size and allowed rotations.
+// The cache empties itself when asked about a bin of another size.
+class OrientationCache {
+public:
+    const OrientationTable& lookup(const Item& item, const std::array<long, 3>& extent);
+
+private:
+    struct Key {
+        std::array<long, 3> size;
+        uint8_t allowed;
+        RotationType first;  // fallback when nothing fits
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    std::unordered_map<Key, OrientationTable, KeyHash> tables;
+    std::array<long, 3> cached_extent = {-1, -1, -1};
+};
+
+#endif // ORIENTATIONS_H
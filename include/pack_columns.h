@@ -0,0 +1,44 @@
+#ifndef PACK_COLUMNS_H
+#define PACK_COLUMNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "packer.h"
+
+// Views over caller-owned arrays, one row per bin or item, such as NumPy
+// buffers. Optional columns may be null. Nothing is read after packColumns()
+// has built the packer's bins and items.
+struct BinColumns {
+    std::size_t count = 0;
+    const long* dimensions = nullptr;  // count x 3: width, height, depth
+    const float* max_weight = nullptr;
+};
+
+struct ItemColumns {
+    std::size_t count = 0;
+    const long* dimensions = nullptr;        // count x 3: width, height, depth
+    const float* weight = nullptr;
+    const uint8_t* rotation_mask = nullptr;  // bit per RotationType; 0 allows all
+    const int32_t* stuffing_layers = nullptr;
+    const float* stuffing_max_weight = nullptr;
+    const long* stuffing_height = nullptr;
+    const long* max_height = nullptr;        // height constraint; 0 for none
+    const uint8_t* bottom_load_only = nullptr;
+    const uint8_t* disable_stacking = nullptr;
+};
+
+// Where one item ended up, laid out to back a NumPy structured array
+struct PlacementRecord {
+    int64_t item;
+    int64_t bin;  // input row of the bin, -1 if the item was not packed
+    int64_t x;
+    int64_t y;
+    int64_t z;
+    int32_t rotation;
+};
+
+// Refill the packer from the columns and pack it under its current options.
+// Writes items.count records to out, record i for item row i.
+void packColumns(Packer& packer, const BinColumns& bins, const ItemColumns& items, PlacementRecord* out);
+
+#endif // PACK_COLUMNS_H
@@ -0,0 +1,100 @@
+#ifndef PACK_OPTIONS_H
+#define PACK_OPTIONS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+
+class PalletPatternCache;
+class PackResultCache;
+
+// Shared flag for stopping a pack from another thread. Copies share the flag,
+// so keep one and hand copies to the packers it should stop.
+class CancelToken {
+public:
+    CancelToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+// Snapshot handed to the progress callback
+struct PackProgress {
+    std::size_t items_placed = 0;
+    std::size_t items_unfit = 0;
+    std::size_t items_total = 0;
+    std::size_t bins_opened = 0;  // bins holding at least one item
+    double fill_rate = 0;         // used volume over the volume of the opened bins
+};
+
+// Why the last pack() returned
+enum class PackStop {
+    FINISHED,
+    DEADLINE,   // time_limit or deadline ran out
+    CANCELLED
+};
+
+// How pack() places items
+enum class PackStrategy {
+    ITEM_BY_ITEM,  // each item at the bin's best free extreme point (the default)
+    WALLS          // whole layers of one item size across the bin, front to back,
+                   // then the rest item by item in the gaps
+};
+
+// Where an item may go in a partly filled bin
+enum class PlacementModel {
+    EXTREME_POINTS,  // corners on the faces of placed items (the default)
+    MAXIMAL_SPACES   // min corners of the largest free cuboids, in every orientation
+};
+
+// Options that change where pack() puts items are part of the result cache
+// key; placementSettings() in packer.cpp lists them.
+struct PackOptions {
+    // Budget of one pack() call, counted from its start
+    std::chrono::milliseconds time_limit{30000};
+    // Absolute stop time on top of time_limit, e.g. one shared by several packers
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    std::optional<CancelToken> cancel;
+    // Called on the packing thread after every batch of items and once at the end
+    std::function<void(const PackProgress&)> progress;
+    PackStrategy strategy = PackStrategy::ITEM_BY_ITEM;
+    PlacementModel placement = PlacementModel::EXTREME_POINTS;
+    // On extreme points, weigh every allowed orientation at every candidate
+    // and keep the pose whose far corner is lowest, then furthest back, then
+    // furthest left, instead of the first one that fits. Not used online.
+    bool best_fit = false;
+    // Share of its base a box off the floor must rest on boxes right below
+    // it, checked on each bin's height map in cells of support_cell. With a
+    // minimum set, candidate positions are first lowered onto the load.
+    // 0 lets boxes float, as before.
+    float min_support = 0.0f;
+    long support_cell = 10;
+    // Load orders of identical unconstrained boxes as a stacked pallet
+    // pattern, ahead of either strategy
+    bool identical_fast_path = true;
+    // Where those patterns are kept; shared by every packer given it. Without
+    // one each pack() solves its pattern afresh.
+    std::shared_ptr<PalletPatternCache> pallet_patterns;
+    // Finished results by canonical order signature, shared like
+    // pallet_patterns. An order of the same item and bin shapes as a stored
+    // one, whatever its names and insertion order, gets the stored layout.
+    std::shared_ptr<PackResultCache> result_cache;
+
+    // Online mode (Packer::placeNext): arrivals held back so the largest can
+    // go first, and bins kept open for new items; the oldest open bin is
+    // closed when another one is opened past the limit
+    std::size_t lookahead = 0;
+    std::size_t max_open_bins = 4;
+    // Candidate points tried per open bin for each online item, 0 for all.
+    // Bounds the work per item as bins fill, at the cost of passing over
+    // gaps further from the origin.
+    std::size_t online_candidates = 64;
+};
+
+#endif // PACK_OPTIONS_H
@@ -0,0 +1,41 @@
+#ifndef PACK_SERVICE_H
+#define PACK_SERVICE_H
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <tuple>
+#include <vector>
+#include "packer.h"
+#include "work_pool.h"
+
+// One independent order: the bins on offer and the items to pack
+struct PackJob {
+    std::vector<Bin> bins;
+    std::vector<Item> items;
+};
+
+// Packs many independent jobs on a fixed pool of worker threads. Every worker
+// keeps one Packer and reuses its buffers from job to job.
+class PackService {
+public:
+    explicit PackService(std::size_t workers = std::thread::hardware_concurrency());
+
+    std::size_t workerCount() const;
+
+    // Pack one job on the calling thread, as a worker would
+    static PackResult packJob(Packer& packer, const PackJob& job);
+
+    // Queue every job; result i belongs to jobs[i]. Errors are rethrown by get().
+    std::vector<std::future<PackResult>> packBatch(std::vector<PackJob> jobs);
+
+    // Queue every job and call done(i, result) on a worker thread as each one
+    // finishes; returns once all callbacks have run
+    void packBatch(std::vector<PackJob> jobs, const std::function<void(std::size_t, PackResult)>& done);
+
+private:
+    std::vector<Packer> packers;  // one per worker
+    WorkPool pool;                // declared last so workers stop before the packers go
+};
+
+#endif // PACK_SERVICE_H
@@ -1,15 +1,88 @@
 #ifndef INCLUDE_PACKER_H
 #define INCLUDE_PACKER_H
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <functional>  // Include for std::reference_wrapper
 #include "../src/bin.h"
+#include "bin_index.h"
 #include "item.h"
+#include "pack_options.h"
+#include "pallet_patterns.h"
+#include "result_cache.h"
+#include "wall_builder.h"
+
+// Order in which pack() hands items to the bins. Items with layer constraints
+// go first and other constrained items next under every order; the order only
+// decides how items within those groups are ranked.
+enum class ItemOrder {
+    VOLUME,        // largest volume first (the default)
+    LONGEST_EDGE,  // longest edge first, then volume
+    BASE_AREA,     // largest width x depth footprint first, then volume
+    WEIGHT,        // heaviest first, then volume
+    RANDOM         // shuffled with the given seed
+};
+
+// A SKU: one prototype item, named by the SKU, and how many copies to pack
+struct ItemType {
+    Item prototype;
+    std::size_t quantity;
+};
+
+// Where an item ended up; indices refer to the bins and items of the order
+struct PackedItem {
+    std::size_t item;
+    std::size_t bin;
+    std::tuple<long, long, long> position;
+    RotationType rotation;
+};
+
+struct PackResult {
+    std::vector<PackedItem> placements;
+    std::vector<std::size_t> unfit;
+};
+
+// A change to an order since it was packed: items taken out, by position in
+// `items`, and new items to pack
+struct OrderDelta {
+    std::vector<std::size_t> removed;
+    std::vector<Item> added;
+};
+
+// Where online mode put an item; bin is null if it went to unfit_items
+struct OnlinePlacement {
+    const Item* item;
+    const Bin* bin;
+};
 
 class Packer {
 public:
     Packer();
+
+    // Copies relink each bin's items to the copy's own `items`, so the copy
+    // can be packed without touching the original
+    Packer(const Packer& other);
+    Packer& operator=(const Packer& other);
+    Packer(Packer&& other) = default;
+    Packer& operator=(Packer&& other) = default;
+
+    // State to return to with rollback(): the placements in every bin, the
+    // unfit list and the pose of every item. Valid while `bins` and `items`
+    // are neither reordered nor resized, so take it after pack() has sorted them.
+    struct Checkpoint {
+        std::vector<std::size_t> bin_marks;
+        std::size_t unfit_count = 0;
+        std::vector<std::pair<std::tuple<long, long, long>, RotationType>> poses;
+    };
+    Checkpoint checkpoint() const;
+    void rollback(const Checkpoint& checkpoint);
     
     const std::vector<Bin>& getBins() const;
     const std::vector<Item>& getItems() const;
@@ -17,11 +90,71 @@ public:
 
     void addBin(const Bin& bin);
     void addItem(const Item& item);
+
+    // Add `quantity` copies of an item and return the id of its SKU, the
+    // prototype's name. Adding a SKU again adds to its quantity; a prototype
+    // with the name of a SKU but other dimensions, weight, rotations or
+    // constraints throws std::invalid_argument. pack() still expands every
+    // SKU into one Item per box, carrying the id in Item::type_id, so memory
+    // and packing work grow with the box count, not the SKU count.
+    std::size_t addItemType(const Item& prototype, std::size_t quantity);
+    const std::vector<ItemType>& getItemTypes() const;
+    // Copies of each SKU placed in a bin, indexed by type id
+    std::vector<std::size_t> getPackedQuantities() const;
+
     std::optional<std::reference_wrapper<Bin>> findFittedBin(Item& item);
     std::optional<std::reference_wrapper<Bin>> getBiggerBinThan(const Bin& other_bin);
+    // The smallest bin bigger than `other_bin` that the item fits in when empty
+    std::optional<std::reference_wrapper<Bin>> getBiggerBinThan(const Bin& other_bin, const Item& item);
     void unfitItem(std::vector<Item*>& item_ptrs);
     std::vector<Item*> packToBin(Bin& bin, std::vector<Item*>& item_ptrs);
+    // Place one item in a bin the way pack() places each item after the
+    // first, or at its best pose over every orientation; every constraint
+    // is checked. The bin is left as it was if it does not fit.
+    bool placeItem(Bin& bin, Item& item, bool best_fit = false);
+    // Place one item with its corner at `position`, in the first allowed
+    // rotation that fits there; checked like placeItem
+    bool placeItemAt(Bin& bin, Item& item, const std::tuple<long, long, long>& position);
     void pack();
+    void pack(ItemOrder order, uint32_t seed = 0);
+    // Empty every bin, then pack `items` in the order of `ranking` (indices
+    // into `items`; constrained items still go first). Items are not moved,
+    // so one packer can decode many orders in turn.
+    void packRanked(const std::vector<std::size_t>& ranking);
+
+    // Time limit, cancellation and progress reporting for later pack() calls.
+    // A pack that stops early keeps what it placed and moves the items it did
+    // not get to into unfit_items.
+    void setOptions(const PackOptions& options);
+    const PackOptions& getOptions() const;
+    PackStop getStopReason() const;
+    PackProgress getProgress() const;
+
+    // Online mode: place arriving items one at a time into the open bins,
+    // leaving earlier placements as they are. Arrivals are kept apart from
+    // `items` so references to them stay valid. Each commit tries at most
+    // PackOptions::online_candidates points per open bin, so its cost stays
+    // bounded as the bins fill. The item waits while the look-ahead buffer
+    // has room, and otherwise the best buffered item is committed.
+    std::optional<OnlinePlacement> placeNext(const Item& item);
+    // Commit every buffered arrival
+    std::vector<OnlinePlacement> flushOnline();
+    const std::deque<Item>& getOnlineItems() const;
+
+    // Warm start: re-pack `items` and `bins`, as `previous` was packed from,
+    // after a small change. Placements of kept items stay where they were
+    // unless they no longer fit; everything else (new items, items that were
+    // unfit and dropped placements) goes into the bins that lost items first,
+    // then the other used bins, then the smallest empty bin. Afterwards
+    // `items` holds the kept items in order followed by the added ones.
+    // False, with nothing changed, if `previous` or `delta` refers to items
+    // or bins the packer does not have.
+    bool repack(const PackResult& previous, const OrderDelta& delta);
+    // The current placements, by position in `bins` and `items`
+    PackResult getResult() const;
+
+    // Drop every bin, item and unfit item but keep the buffers for the next order
+    void reset();
     
     // Public data members
     std::vector<Item> items;
@@ -29,18 +162,115 @@ public:
     std::vector<Item> unfit_items;
     
 private:
-    // Helper function to calculate overlap between items - changed to use vector
-    float calculateItemOverlap(const std::tuple<long, long, long>& pos1, const std::vector<long>& dim1,
-                              const std::tuple<long, long, long>& pos2, const std::vector<long>& dim2) const;
+    // Helper function to calculate overlap between items
+    float calculateItemOverlap(const std::tuple<long, long, long>& pos1, const std::array<long, 3>& dim1,
+                              const std::tuple<long, long, long>& pos2, const std::array<long, 3>& dim2) const;
 
     // Helper function to check if an item is directly above another with significant overlap
     bool isItemDirectlyAbove(const Item& bottom_item, const Item& top_item, float overlap_threshold) const;
 
+    // Rebuild bin_index if the bins changed since it was built
+    const BinIndex& getBinIndex();
+
+    // Whether the item passes checkStuffingConstraints with nothing else around
+    static bool canStandAlone(const Item& item);
+
     // Check if item's stuffing constraints are satisfied in this position
     bool checkStuffingConstraints(const Bin& bin, const Item& item, const std::tuple<long, long, long>& position);
     
     // Check if placing this item would violate constraints of items below it
-    bool wouldViolateExistingItemConstraints(const Bin& bin, const Item& new_item, const std::tuple<long, long, long>& new_position);
+    bool wouldViolateExistingItemConstraints(const Bin& bin, const Item& new_item);
+
+    // Try the item at the bin's free extreme points; it stays where it first
+    // fits. Online the walk is budgeted, and points passed over are blocked
+    // for items as thick as this one and retired once inside a placed box.
+    bool placeAtCandidates(Bin& bin, Item& item, bool online = false);
+
+    // PackOptions::best_fit: the best pose over every candidate and
+    // orientation. Candidates come nearest first, so the walk stops once
+    // none left can beat the best pose found; with a support minimum each
+    // pose is lowered onto the load first and the walk goes to the end.
+    bool placeBestFit(Bin& bin, Item& item);
+
+    // Whether a pose meets PackOptions::min_support in the bin as it is
+    bool isSupported(const Bin& bin, const ItemGeometry& geometry) const;
+
+    // PlacementModel::MAXIMAL_SPACES: put the item at the nearest free space
+    // it fits in any orientation, better scored orientations first on a tie.
+    // Rejects an item no space holds without testing a single position.
+    bool placeInMaximalSpace(Bin& bin, Item& item);
+
+    // Identical boxes: stack the bin's pallet pattern into each empty bin in
+    // turn. Removes every item it places from `remaining`.
+    void packIdentical(std::vector<Item*>& remaining);
+
+    // PackStrategy::WALLS: fill each bin in turn with layers, then its gaps.
+    // Removes every item it places from `remaining`.
+    void packWalls(std::vector<Item*>& remaining);
+    // Place the best layer at depth `front` of the bin; returns its depth, 0 if none fits
+    long placeWall(Bin& bin, long front, std::vector<Item*>& remaining, FacePatternCache& patterns);
+
+    // Pose the items as a cached result says; false, with nothing changed,
+    // if it does not match the signature's items and bins
+    bool replayResult(const OrderSignature& signature, const CachedResult& result);
+    // The current placements in the signature's canonical positions
+    CachedResult recordResult(const OrderSignature& signature) const;
+
+    // Online mode: place the buffered arrival that goes first in pack()'s
+    // volume order, in an open bin or else the smallest empty bin it fits
+    OnlinePlacement commitOnline();
+
+    // Place the item alone in the smallest empty bin that takes it; returns
+    // the bin's position in `bins`
+    std::optional<std::size_t> placeInEmptyBin(Item& item, bool online = false);
+
+    // Warm start: put the item back as a previous solution had it, if that
+    // pose is still allowed and free
+    bool keepPlacement(Bin& bin, Item& item, const PackedItem& placement);
+
+    // pack()'s main loop: find a bin for the first remaining item, then let
+    // packToBin carry on with the rest in that bin
+    void packRemaining(std::vector<Item*>& remaining_items);
+
+    // Append the copies of every SKU not yet turned into items
+    void expandItemTypes();
+
+    // Whether to stop now; records why in stop_reason
+    bool shouldStop();
+    void reportProgress() const;
+
+    BinIndex bin_index;
+    std::vector<ItemType> item_types;
+    std::vector<std::size_t> expanded_quantities;  // copies already in `items`, per type
+    std::unordered_map<std::string, std::size_t> type_ids;
+    std::deque<Item> online_items;       // every arrival, in arrival order
+    std::vector<Item*> online_buffer;    // arrivals not yet committed
+    std::vector<std::size_t> open_bins;  // positions in `bins`, oldest first
+    std::vector<std::tuple<long, long, long>> passed_over;  // scratch for placeAtCandidates
+    std::vector<std::pair<std::array<long, 3>, const Orientation*>> space_choices;  // scratch for placeInMaximalSpace
+    PackOptions options;
+    std::chrono::steady_clock::time_point stop_time = std::chrono::steady_clock::time_point::max();
+    PackStop stop_reason = PackStop::FINISHED;
+};
+
+// What-if scope over a Packer: everything placed through the packer while the
+// fork is alive is undone when it goes out of scope, unless commit() was called
+class PackerFork {
+public:
+    explicit PackerFork(Packer& packer);
+    ~PackerFork();
+    PackerFork(const PackerFork&) = delete;
+    PackerFork& operator=(const PackerFork&) = delete;
+
+    // Keep the changes made so far
+    void commit();
+    // Undo the changes made so far and keep forking from the original state
+    void rollback();
+
+private:
+    Packer& packer;
+    Packer::Checkpoint checkpoint;
+    bool committed;
 };
 
 #endif // INCLUDE_PACKER_H
@@ -0,0 +1,54 @@
+#ifndef PALLET_PATTERNS_H
+#define PALLET_PATTERNS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "item.h"
+#include "lru_cache.h"
+#include "wall_builder.h"
+
+// What decides a pallet pattern: the box, its allowed rotations (bit per
+// RotationType), the bin and both weights
+struct PalletKey {
+    std::array<long, 3> box;
+    uint8_t allowed;
+    float box_weight;
+    std::array<long, 3> bin;
+    float bin_max_weight;
+
+    bool operator<(const PalletKey& other) const;
+};
+
+// Identical boxes on the bin's floor in a guillotine pattern over width x
+// depth, stacked in layers up the height. Cells of one layer are (x, z)
+// pairs; turned cells use the `turned` rotation.
+struct PalletPattern {
+    RotationType rotation = RotationType::whd;
+    RotationType turned = RotationType::whd;
+    long layer_height = 0;
+    std::size_t layers = 0;
+    std::size_t capacity = 0;  // boxes the bin takes, weight limit included
+    std::vector<FaceCell> cells;
+};
+
+// Best pattern over the allowed rotations: most boxes, then fewest layers
+PalletPattern solvePalletPattern(const PalletKey& key);
+
+// Solved patterns by key, bounded in entries; save() and load() keep them in
+// a plain text file
+class PalletPatternCache : public LruCache<PalletKey, PalletPattern, std::map> {
+public:
+    explicit PalletPatternCache(std::size_t capacity = 1024);
+
+    // The cached pattern for the key, solving and storing it on a miss
+    PalletPattern lookup(const PalletKey& key);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+#endif // PALLET_PATTERNS_H
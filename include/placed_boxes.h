@@ -0,0 +1,58 @@
+#ifndef PLACED_BOXES_H
+#define PLACED_BOXES_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "item.h"
+#include "spatial_grid.h"
+
+// Constraint bits copied out of an Item so scans can filter without touching it
+enum PlacedFlag : uint8_t {
+    PLACED_BOTTOM_LOAD_ONLY = 1 << 0,
+    PLACED_DISABLE_STACKING = 1 << 1,
+    PLACED_HEIGHT_CONSTRAINED = 1 << 2,
+    PLACED_STUFFING_LIMITS = 1 << 3   // stuffing layers, weight or height set
+};
+
+uint8_t placementFlags(const Item& item);
+
+// Running totals over a prefix of the placed boxes
+struct PlacedTotals {
+    float weight = 0.0f;
+    long volume = 0;
+    GridBox bounds{{0, 0, 0}, {0, 0, 0}};           // box around the load, all zero when empty
+    std::array<double, 3> weight_moment{0, 0, 0};   // sums of weight x box centre
+    std::array<double, 3> volume_moment{0, 0, 0};   // sums of volume x box centre
+};
+
+// Structure-of-arrays copy of the boxes placed in a bin, index-aligned with
+// Bin::items. Overlap, weight and support scans stream through these arrays
+// instead of following references into the much larger Item objects.
+struct PlacedBoxes {
+    std::vector<long> min_x, min_y, min_z;
+    std::vector<long> max_x, max_y, max_z;
+    std::vector<float> weight;
+    std::vector<uint8_t> flags;
+
+    // totals[i] covers boxes 0..i, so undoing a push restores the previous
+    // totals exactly instead of subtracting
+    std::vector<PlacedTotals> totals;
+
+    std::size_t size() const;
+    void push(const ItemGeometry& geometry, uint8_t item_flags);
+    void pop();
+    void clear();
+
+    // Totals over every box, zero when empty
+    const PlacedTotals& total() const;
+
+    GridBox box(std::size_t index) const;
+    bool overlaps(std::size_t index, const GridBox& other) const;
+
+    // Footprint (width x depth) of a box and its overlap with another footprint
+    long baseArea(std::size_t index) const;
+    float baseOverlap(std::size_t index, const GridBox& other) const;
+};
+
+#endif // PLACED_BOXES_H
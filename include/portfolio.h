@@ -0,0 +1,60 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "packer.h"
+
+enum class PortfolioObjective {
+    PACKED_VOLUME,  // most volume packed, then fewest bins used
+    BINS_USED       // fewest bins used, then most volume packed
+};
+
+struct PortfolioOptions {
+    // The first runs pack each fixed order of ITEM_ORDERS once; every later
+    // run packs a random order seeded with seed + k
+    std::size_t runs = 8;
+    uint32_t seed = 0;
+    std::size_t threads = std::thread::hardware_concurrency();
+    // Wall-clock budget for the whole portfolio; runs still going when it
+    // expires stop early and compete with what they packed so far
+    std::chrono::milliseconds budget{30000};
+    PortfolioObjective objective = PortfolioObjective::PACKED_VOLUME;
+    // Replaces `objective` when set; higher is better
+    std::function<double(const Packer&)> score;
+};
+
+struct PortfolioRun {
+    ItemOrder order;
+    uint32_t seed;
+    double packed_volume;
+    std::size_t bins_used;
+    std::size_t unfit;
+    bool finished;  // false if the deadline or the cancel token cut the run short
+};
+
+struct PortfolioResult {
+    std::vector<PortfolioRun> runs;
+    std::size_t best;  // index into runs
+};
+
+// The orders the portfolio tries, default order first and RANDOM last
+extern const std::vector<ItemOrder> ITEM_ORDERS;
+
+double packedVolume(const Packer& packer);
+std::size_t binsUsed(const Packer& packer);
+
+// Whether packing `volume` in `bins` beats packing `other_volume` in
+// `other_bins` under the objective; totals and changes compare alike
+bool packsBetter(double volume, long bins, double other_volume, long other_bins, PortfolioObjective objective);
+
+// Pack copies of `packer` under several item orders in parallel and leave the
+// best solution in `packer`. Ties go to the lower run index, so the result
+// only depends on the options as long as every run finishes in the budget.
+PortfolioResult packPortfolio(Packer& packer, const PortfolioOptions& options = {});
+
+#endif // PORTFOLIO_H
@@ -0,0 +1,50 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../src/bin.h"
+#include "item.h"
+#include "lru_cache.h"
+
+// Canonical form of an order. Items and bins are ranked by the fields that
+// matter to packing; names, colours and insertion order play no part. Items
+// or bins of equal rank fields are interchangeable, so a result stored for
+// one order can be replayed onto any order with the same key.
+struct OrderSignature {
+    std::string key;                       // settings plus the sorted item and bin multisets
+    std::vector<std::size_t> item_ranks;   // canonical position -> index in `items`
+    std::vector<std::size_t> bin_ranks;    // canonical position -> index in `bins`
+};
+
+// `settings` describes everything else the result depends on, such as the
+// item order and strategy; it must not contain whitespace
+OrderSignature signOrder(const std::vector<Bin>& bins, const std::vector<Item>& items, const std::string& settings);
+
+// A packed result in canonical positions, in placement order per bin
+struct CachedPlacement {
+    uint32_t item;
+    uint32_t bin;
+    std::array<long, 3> position;
+    RotationType rotation;
+};
+
+struct CachedResult {
+    std::vector<CachedPlacement> placements;
+    std::vector<uint32_t> unfit;
+};
+
+// Finished pack results by signature key, bounded both in entries and in
+// placements held; save() and load() keep them in a plain text file
+class PackResultCache : public LruCache<std::string, CachedResult> {
+public:
+    explicit PackResultCache(std::size_t max_entries = 1024, std::size_t max_placements = 1 << 20);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,94 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Half-open integer box [min, max) on the (width, height, depth) axes
+struct GridBox {
+    std::array<long, 3> min;
+    std::array<long, 3> max;
+};
+
+// Uniform grid over a bin's interior used to find placed items near a box.
+// Ids are opaque to the grid; Bin uses the index of the item in Bin::items.
+// Queries keep no scratch state, so they may nest and run concurrently.
+class SpatialGrid {
+public:
+    SpatialGrid();
+
+    // Resize the grid to cover a w x h x d bin and drop every entry
+    void reset(long w, long h, long d);
+    void clear();
+    bool covers(long w, long h, long d) const;
+    std::size_t size() const;
+
+    void insert(uint32_t id, const GridBox& box);
+    void remove(uint32_t id);
+    const GridBox& boxOf(uint32_t id) const;
+
+    // Call visit(id) once for every entry whose cells touch the region.
+    // Entries are candidates only; callers do the exact overlap test.
+    // Stops early and returns true as soon as visit returns true.
+    template <typename Visitor>
+    bool forEachInRegion(const GridBox& region, Visitor&& visit) const;
+
+private:
+    void cellRange(const GridBox& box, std::array<int, 3>& lo, std::array<int, 3>& hi) const;
+    std::size_t cellIndex(int x, int y, int z) const;
+    void eraseFrom(std::vector<uint32_t>& bucket, uint32_t id);
+
+    std::array<long, 3> extent;
+    std::array<long, 3> cell_size;
+    std::array<int, 3> cell_count;
+    std::vector<std::vector<uint32_t>> cells;  // allocated on first insert
+    std::vector<uint32_t> flat;                // boxes with a zero-length side
+    std::size_t entry_count;
+
+    // Box and first covered cell of every id; an id spanning several cells is
+    // only reported from the first cell it shares with the query region
+    std::vector<GridBox> boxes;
+    std::vector<std::array<int, 3>> first_cells;
+};
+
+template <typename Visitor>
+bool SpatialGrid::forEachInRegion(const GridBox& region, Visitor&& visit) const {
+    if (entry_count == 0) {
+        return false;
+    }
+
+    // Degenerate boxes never occupy a cell, report them to every query
+    for (uint32_t id : flat) {
+        if (visit(id)) {
+            return true;
+        }
+    }
+    if (cells.empty()) {
+        return false;
+    }
+
+    std::array<int, 3> lo, hi;
+    cellRange(region, lo, hi);
+    for (int x = lo[0]; x <= hi[0]; ++x) {
+        for (int y = lo[1]; y <= hi[1]; ++y) {
+            for (int z = lo[2]; z <= hi[2]; ++z) {
+                for (uint32_t id : cells[cellIndex(x, y, z)]) {
+                    const auto& first = first_cells[id];
+                    if (std::max(first[0], lo[0]) != x ||
+                        std::max(first[1], lo[1]) != y ||
+                        std::max(first[2], lo[2]) != z) {
+                        continue;
+                    }
+                    if (visit(id)) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,63 @@
+#ifndef SUPPORT_GRAPH_H
+#define SUPPORT_GRAPH_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "placed_boxes.h"
+#include "spatial_grid.h"
+
+// One box lying above another with a share of the lower box's footprint
+struct SupportEdge {
+    uint32_t index;   // the box at the other end
+    float overlap;    // footprint overlap, as Packer::calculateItemOverlap
+    bool resting;     // overlap covers at least RESTING_SHARE of the lower footprint
+};
+
+// Which placed boxes of a bin lie above which, index-aligned with PlacedBoxes.
+// A box is above another when its bottom is at or over the other's top and
+// their footprints overlap (any box counts over a zero-area footprint).
+// Every box also keeps the load, top height and distinct layers of the boxes
+// resting on it, so stacking checks only read a box and its neighbours.
+class SupportGraph {
+public:
+    static constexpr float RESTING_SHARE = 0.5f;
+
+    SupportGraph();
+
+    void clear();
+    std::size_t size() const;
+
+    // Link the next unlinked box of `boxes` with the boxes placed before it.
+    // `grid` must index `boxes` by position.
+    void push(const PlacedBoxes& boxes, const SpatialGrid& grid);
+
+    // Unlink the latest box
+    void pop(const PlacedBoxes& boxes);
+
+    const std::vector<SupportEdge>& above(std::size_t index) const;
+    const std::vector<SupportEdge>& below(std::size_t index) const;
+
+    // Aggregates over the boxes resting on `index`
+    float loadAbove(std::size_t index) const;
+    long topAbove(std::size_t index) const;      // highest top, or 0 if none
+    std::size_t layersAbove(std::size_t index) const;
+
+private:
+    struct Node {
+        std::vector<SupportEdge> above;
+        std::vector<SupportEdge> below;
+        std::vector<std::pair<long, uint32_t>> layers;  // resting bottom heights and their counts, sorted
+        float load = 0.0f;
+        long top = 0;
+    };
+
+    void link(const PlacedBoxes& boxes, uint32_t bottom, uint32_t top);
+    void unlinkResting(const PlacedBoxes& boxes, uint32_t bottom, uint32_t top);
+
+    // Nodes past `count` keep their buffers for the next push
+    std::vector<Node> nodes;
+    std::size_t count;
+};
+
+#endif // SUPPORT_GRAPH_H
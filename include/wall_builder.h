@@ -0,0 +1,34 @@
+#ifndef WALL_BUILDER_H
+#define WALL_BUILDER_H
+
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// One rectangle of a face pattern, at (x, y) from the face's corner. Turned
+// rectangles stand b x a instead of a x b.
+struct FaceCell {
+    long x;
+    long y;
+    bool turned;
+};
+
+// Cells of a guillotine pattern placing as many a x b rectangles as it can on
+// a width x height face, turned ones too when `turn` is set. Cuts are only
+// tried at lengths made of whole rectangle sides; when there are too many of
+// those the best single-direction block is returned instead. Cells come
+// bottom row first so a pattern cut short still stands on the floor.
+std::vector<FaceCell> guillotinePattern(long width, long height, long a, long b, bool turn);
+
+// Patterns solved so far; a load of few item sizes asks for the same ones
+// layer after layer
+class FacePatternCache {
+public:
+    const std::vector<FaceCell>& lookup(long width, long height, long a, long b, bool turn);
+
+private:
+    std::map<std::tuple<long, long, long, long, bool>, std::vector<FaceCell>> patterns;
+};
+
+#endif // WALL_BUILDER_H
@@ -0,0 +1,52 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. Submitted tasks
+// are dealt round-robin; a worker runs its own newest task first and, when
+// its deque is empty, steals the oldest task of another worker.
+// Tasks get the index of the worker running them, so callers can keep state
+// per worker and reuse it from one task to the next.
+class WorkPool {
+public:
+    using Task = std::function<void(std::size_t worker)>;
+
+    explicit WorkPool(std::size_t workers);
+    ~WorkPool();
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    std::size_t size() const;
+    void submit(Task task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(std::size_t worker);
+    bool popOwn(std::size_t worker, Task& task);
+    bool steal(std::size_t worker, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> next_queue;
+
+    // Sleeping workers wait here for pending work or shutdown
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::size_t pending;
+    bool stopping;
+};
+
+#endif // WORK_POOL_H
@@ -1,9 +1,88 @@
 #include "packer.h"
 #include "bin.h"
 #include "item.h"
+#include "box_kernels.h"
+#include "pack_columns.h"
+#include "pack_service.h"
+#include "portfolio.h"
+#include "local_search.h"
+#include "brkga.h"
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
+// Counts every global allocation so tests can check the placement hot paths stay off the heap.
+// Every form of operator new and delete is replaced, and all of them go
+// through the two functions below, so allocation and release always match.
+static std::atomic<std::size_t> allocation_count{0};
+
+__attribute__((noinline)) static void* countedAllocate(std::size_t size) noexcept {
+    ++allocation_count;
+    return std::malloc(size ? size : 1);
+}
+
+__attribute__((noinline)) static void countedRelease(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) {
+    if (void* ptr = countedAllocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* ptr = countedAllocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    countedRelease(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    countedRelease(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    countedRelease(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    countedRelease(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    countedRelease(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    countedRelease(ptr);
+}
+
 void runTest(const std::string& testName, const std::vector<Bin>& bins, const std::vector<Item>& items, const std::function<bool(const Packer&)>& expectation) {
     Packer packer;
     for (const auto& bin : bins) {
@@ -20,7 +99,1211 @@ void runTest(const std::string& testName, const std::vector<Bin>& bins, const st
     }
 }
 
-long main() {
+void runAllocationTest() {
+    Packer packer;
+    packer.addBin(Bin("Bin 1", 100, 100, 100));
+    for (int i = 0; i < 60; ++i) {
+        packer.addItem(Item("Item " + std::to_string(i), 10, 20, 30));
+    }
+    // Fill the bin through the placement search these paths belong to
+    PackOptions options;
+    options.identical_fast_path = false;
+    packer.setOptions(options);
+    packer.pack();
+
+    const Bin& bin = packer.getBins()[0];
+    Item probe("Probe", 15, 25, 35);
+
+    // Let the bin build its lazily maintained state before counting
+    bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& position) {
+        return bin.canItemFit(probe, position);
+    });
+    bin.getBestRotationOrder(probe, {0, 0, 0});
+
+    std::size_t before = allocation_count;
+    for (long x = 0; x < 100; x += 10) {
+        for (long z = 0; z < 100; z += 10) {
+            std::tuple<long, long, long> position{x, 0, z};
+            for (auto rotation : probe.getAllowedRotations()) {
+                bin.scoreRotation(probe, position, rotation);
+                bin.intersectsPlacedItem(probe.getGeometry(rotation, position));
+            }
+            bin.getBestRotationOrder(probe, position);
+            bin.canItemFit(probe, position);
+        }
+    }
+    bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& position) {
+        bin.canItemFit(probe, position);
+        return false;
+    });
+    std::size_t allocations = allocation_count - before;
+
+    if (allocations == 0) {
+        std::cout << "Placement hot paths do not allocate: PASSED" << std::endl;
+    } else {
+        std::cout << "Placement hot paths do not allocate: FAILED (" << allocations << " allocations)" << std::endl;
+    }
+}
+
+void runKernelTest() {
+    // Compare the batched kernels with plain per-box tests on pseudo-random boxes
+    unsigned state = 12345;
+    auto next = [&state](long range) {
+        state = state * 1103515245u + 12345u;
+        return static_cast<long>((state >> 8) % static_cast<unsigned>(range));
+    };
+
+    PlacedBoxes boxes;
+    for (int i = 0; i < 70; ++i) {
+        ItemGeometry geometry{{next(20) + 1, next(20) + 1, next(20) + 1}, {next(50), next(50), next(50)}, RotationType::whd, 1.0f};
+        boxes.push(geometry, 0);
+    }
+
+    bool passed = true;
+    for (int trial = 0; trial < 200 && passed; ++trial) {
+        GridBox box{{next(50), next(50), next(50)}, {0, 0, 0}};
+        for (int axis = 0; axis < 3; ++axis) {
+            box.max[axis] = box.min[axis] + next(20) + 1;
+        }
+        std::size_t begin = next(10);
+
+        std::size_t expected_first = boxes.size();
+        for (std::size_t i = begin; i < boxes.size(); ++i) {
+            if (boxes.overlaps(i, box)) {
+                expected_first = std::min(expected_first, i);
+            }
+        }
+        passed = firstOverlap(boxes, begin, boxes.size(), box) == expected_first;
+    }
+
+    std::array<std::array<long, 3>, 6> dims;
+    for (int r = 0; r < 6; ++r) {
+        dims[r] = rotateDimension(30, 50, 70, static_cast<RotationType>(r));
+    }
+    std::array<std::array<long, 3>, 11> positions;
+    for (auto& p : positions) {
+        p = {next(80), next(80), next(80)};
+    }
+    std::array<long, 3> extent = {100, 90, 110};
+    uint8_t masks[11];
+    boundsFitMasks(positions.data(), positions.size(), dims.data(), dims.size(), extent, masks);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        for (int r = 0; r < 6; ++r) {
+            bool fits = positions[i][0] + dims[r][0] <= extent[0] &&
+                        positions[i][1] + dims[r][1] <= extent[1] &&
+                        positions[i][2] + dims[r][2] <= extent[2];
+            passed = passed && fits == (((masks[i] >> r) & 1) != 0);
+        }
+    }
+
+    std::cout << "Batched box kernels match scalar tests" << (boxKernelsUseAvx2() ? " (AVX2)" : "")
+              << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// Recompute what the support graph keeps for one box from the packed boxes
+static bool supportMatchesRescan(const Bin& bin, std::size_t index) {
+    const PlacedBoxes& boxes = bin.getPlacedBoxes();
+    const SupportGraph& support = bin.getSupportGraph();
+    float area = static_cast<float>(boxes.baseArea(index));
+    std::size_t edges = 0;
+    long top = 0;
+    std::set<long> layers;
+    for (std::size_t other = 0; other < boxes.size(); ++other) {
+        if (other == index || boxes.min_y[other] < boxes.max_y[index]) {
+            continue;
+        }
+        float overlap = boxes.baseOverlap(index, boxes.box(other));
+        if (overlap <= 0.0f && area != 0.0f) {
+            continue;
+        }
+        ++edges;
+        if (overlap >= SupportGraph::RESTING_SHARE * area) {
+            top = std::max(top, boxes.max_y[other]);
+            layers.insert(boxes.min_y[other]);
+        }
+    }
+    return support.above(index).size() == edges && support.topAbove(index) == top &&
+           support.layersAbove(index) == layers.size();
+}
+
+void runSupportGraphTest() {
+    // Stack boxes of mixed sizes, then undo the latest placements one by one
+    Bin bin("Bin", 100, 100, 100);
+    std::vector<Item> items;
+    items.reserve(40);
+    for (int i = 0; i < 40; ++i) {
+        items.emplace_back("Item " + std::to_string(i), 10 + (i % 3) * 10, 10 + (i % 4) * 5, 10 + (i % 2) * 20);
+    }
+
+    bool passed = true;
+    std::size_t placed = 0;
+    for (Item& item : items) {
+        bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& position) {
+            return bin.putItem(item, position);
+        });
+        placed = bin.getItems().size();
+        for (std::size_t index = 0; index < placed; ++index) {
+            passed = passed && supportMatchesRescan(bin, index);
+        }
+    }
+    while (!bin.getItems().empty()) {
+        bin.removeItem(bin.getItems().back().get());
+        for (std::size_t index = 0; index < bin.getItems().size(); ++index) {
+            passed = passed && supportMatchesRescan(bin, index);
+        }
+    }
+
+    std::cout << "Support graph matches a rescan: " << (passed && placed > 1 ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runBinTotalsTest() {
+    Bin bin("Bin", 100, 100, 100);
+    Item a("A", 20, 10, 40, {RotationType::whd}, "red", 5.0f);
+    Item b("B", 30, 20, 10, {RotationType::whd}, "red", 15.0f);
+    bool passed = bin.putItem(a, {0, 0, 0}) && bin.putItem(b, {20, 0, 0});
+
+    auto center = bin.getCenterOfMass();
+    passed = passed && bin.getTotalWeight() == 20.0f && bin.getUsedVolume() == 8000 + 6000 &&
+             bin.getMaxOccupied() == std::array<long, 3>{50, 20, 40} &&
+             center[0] == (5.0 * 10 + 15.0 * 35) / 20 && center[1] == (5.0 * 5 + 15.0 * 10) / 20;
+
+    // Removing an item restores the previous totals
+    bin.removeItem(b);
+    passed = passed && bin.getTotalWeight() == 5.0f && bin.getUsedVolume() == 8000 &&
+             bin.getMaxOccupied() == std::array<long, 3>{20, 10, 40};
+    bin.setItems({});
+    passed = passed && bin.getTotalWeight() == 0.0f && bin.getFillRatio() == 0.0;
+
+    std::cout << "Bin totals follow placements: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runForkTest() {
+    Packer packer;
+    packer.addBin(Bin("Bin", 100, 100, 100));
+    for (int i = 0; i < 6; ++i) {
+        packer.addItem(Item("Item " + std::to_string(i), 50, 50, 50));
+    }
+    packer.pack();
+    packer.addItem(Item("Extra", 10, 10, 10));
+
+    // A copy packs on its own items
+    Packer copy(packer);
+    const Item* first = &copy.getBins()[0].getItems()[0].get();
+    bool passed = first >= copy.getItems().data() && first < copy.getItems().data() + copy.getItems().size();
+
+    std::size_t placed = packer.getBins()[0].getItems().size();
+    auto position = packer.getItems()[0].getPosition();
+    {
+        PackerFork fork(packer);
+        Bin& bin = packer.bins[0];
+        Item& extra = packer.items.back();
+        bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& p) {
+            return bin.putItem(extra, p);
+        });
+        std::vector<Item*> rest = {&packer.items[0]};
+        packer.unfitItem(rest);
+        passed = passed && bin.getItems().size() == placed + 1 && packer.getUnfitItems().size() == 1;
+    }
+    passed = passed && packer.getBins()[0].getItems().size() == placed &&
+             packer.getUnfitItems().empty() && packer.getItems()[0].getPosition() == position &&
+             copy.getBins()[0].getItems().size() == placed;
+
+    std::cout << "Forked packing is rolled back: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runBinProbeTest() {
+    Packer packer;
+    packer.addBin(Bin("Large", 300, 300, 300));
+    packer.addBin(Bin("Flat", 400, 20, 400));
+    packer.addBin(Bin("Small", 100, 100, 100));
+    packer.addBin(Bin("Tall", 50, 500, 50));
+    Item upright("Upright", 40, 200, 40, {RotationType::whd});
+    Item any("Any", 200, 40, 40);
+
+    const Bin& tall = packer.getBins()[3];
+    bool passed = tall.probe(upright) == (1u << static_cast<int>(RotationType::whd)) &&
+                  tall.probe(any) == ((1u << static_cast<int>(RotationType::hwd)) | (1u << static_cast<int>(RotationType::dwh))) &&
+                  packer.getBins()[2].probe(any) == 0 && tall.getItems().empty();
+
+    // Smallest bin the item fits in, then the next bigger one it fits in
+    auto fitted = packer.findFittedBin(upright);
+    passed = passed && fitted && fitted->get().getName() == "Tall" && fitted->get().getItems().empty();
+    auto bigger = packer.getBiggerBinThan(fitted->get(), upright);
+    passed = passed && bigger && bigger->get().getName() == "Large";
+    passed = passed && !packer.getBiggerBinThan(packer.getBins()[0], upright);
+
+    // A bin that already holds items is tried and left as it was
+    Packer used;
+    used.addBin(Bin("Used", 100, 100, 100));
+    Item corner("Corner", 50, 50, 50);
+    Item cube("Cube", 40, 40, 40);
+    passed = passed && used.bins[0].putItem(corner, {50, 0, 0});
+    auto tried = used.findFittedBin(cube);
+    passed = passed && tried && tried->get().getItems().size() == 1;
+
+    std::cout << "Bins are probed without placing: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runOrientationTableTest() {
+    Bin bin("Bin", 100, 60, 40);
+    Item cube("Cube", 30, 30, 30);
+    Item square("Square", 20, 20, 50);
+    Item upright("Upright", 20, 20, 50, {RotationType::whd});
+
+    const OrientationTable& cubes = bin.getOrientations(cube);
+    const OrientationTable& squares = bin.getOrientations(square);
+    bool passed = cubes.count == 1 && squares.count == 3 && bin.getOrientations(upright).count == 1;
+
+    // The cached pick agrees with scoring every allowed rotation
+    for (const Item* item : {&cube, &square, &upright}) {
+        RotationType best = item->getAllowedRotations()[0];
+        float best_score = 0;
+        for (auto rotation : item->getAllowedRotations()) {
+            float score = bin.scoreRotation(*item, {0, 0, 0}, rotation);
+            if (score > best_score || (score == best_score && score > 0 && rotation < best)) {
+                best_score = score;
+                best = rotation;
+            }
+        }
+        passed = passed && bin.getBestRotationOrder(*item, {0, 0, 0}) == best;
+    }
+    passed = passed && bin.probe(upright) == 0 && bin.probe(square) != 0;
+
+    std::cout << "Orientation tables drop repeated sizes: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// Pseudo-random orders of cartons, the same on every run
+static std::vector<PackJob> makeJobs(std::size_t count) {
+    unsigned state = 2024;
+    auto next = [&state](long low, long high) {
+        state = state * 1103515245u + 12345u;
+        return low + static_cast<long>((state >> 8) % static_cast<unsigned>(high - low + 1));
+    };
+
+    std::vector<PackJob> jobs(count);
+    for (auto& job : jobs) {
+        job.bins = {Bin("Small", 400, 300, 300), Bin("Medium", 600, 400, 400), Bin("Large", 1200, 1000, 800)};
+        long item_count = next(5, 40);
+        for (long i = 0; i < item_count; ++i) {
+            job.items.emplace_back("Item " + std::to_string(i), next(1, 6) * 50, next(1, 6) * 50, next(1, 6) * 50,
+                                   std::vector<RotationType>{}, "red", static_cast<float>(next(1, 30)));
+        }
+    }
+    return jobs;
+}
+
+static bool samePlacements(const PackResult& a, const PackResult& b) {
+    if (a.placements.size() != b.placements.size() || a.unfit != b.unfit) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.placements.size(); ++i) {
+        const PackedItem& x = a.placements[i];
+        const PackedItem& y = b.placements[i];
+        if (x.item != y.item || x.bin != y.bin || x.position != y.position || x.rotation != y.rotation) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void runPackServiceTest() {
+    std::vector<PackJob> jobs = makeJobs(24);
+    std::vector<PackResult> expected;
+    Packer packer;
+    for (const auto& job : jobs) {
+        expected.push_back(PackService::packJob(packer, job));
+    }
+
+    PackService service(4);
+    auto futures = service.packBatch(jobs);
+    bool passed = futures.size() == jobs.size();
+    for (std::size_t i = 0; i < futures.size() && passed; ++i) {
+        passed = samePlacements(futures[i].get(), expected[i]);
+    }
+
+    std::vector<bool> seen(jobs.size(), false);
+    std::mutex seen_mutex;
+    service.packBatch(jobs, [&](std::size_t i, PackResult result) {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        seen[i] = samePlacements(result, expected[i]);
+    });
+    passed = passed && std::find(seen.begin(), seen.end(), false) == seen.end();
+
+    std::cout << "Batch service matches packing one by one: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runPackColumnsTest() {
+    std::vector<PackJob> jobs = makeJobs(8);
+    Packer packer;
+    bool passed = true;
+    for (const auto& job : jobs) {
+        PackResult expected = PackService::packJob(packer, job);
+
+        // Same job as flat columns
+        std::vector<long> bin_dims;
+        for (const auto& bin : job.bins) {
+            bin_dims.insert(bin_dims.end(), {bin.getWidth(), bin.getHeight(), bin.getDepth()});
+        }
+        std::vector<long> item_dims;
+        std::vector<float> weights;
+        for (const auto& item : job.items) {
+            item_dims.insert(item_dims.end(), {item.getWidth(), item.getHeight(), item.getDepth()});
+            weights.push_back(item.weight);
+        }
+        BinColumns bins;
+        bins.count = job.bins.size();
+        bins.dimensions = bin_dims.data();
+        ItemColumns items;
+        items.count = job.items.size();
+        items.dimensions = item_dims.data();
+        items.weight = weights.data();
+
+        std::vector<PlacementRecord> records(items.count);
+        packColumns(packer, bins, items, records.data());
+
+        for (const auto& placed : expected.placements) {
+            const PlacementRecord& record = records[placed.item];
+            passed = passed && record.bin == static_cast<int64_t>(placed.bin) &&
+                     std::make_tuple(record.x, record.y, record.z) == std::tuple<int64_t, int64_t, int64_t>(placed.position) &&
+                     record.rotation == static_cast<int32_t>(placed.rotation);
+        }
+        for (std::size_t unfit : expected.unfit) {
+            passed = passed && records[unfit].bin == -1;
+        }
+    }
+
+    std::cout << "Column packing matches packing items: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// Where every item of a packer ended up, by item name
+static std::vector<std::tuple<std::string, std::string, std::tuple<long, long, long>, RotationType>> layout(const Packer& packer) {
+    std::vector<std::tuple<std::string, std::string, std::tuple<long, long, long>, RotationType>> result;
+    for (const auto& bin : packer.getBins()) {
+        for (const auto& ref : bin.getItems()) {
+            const Item& item = ref.get();
+            result.emplace_back(item.getName(), bin.getName(), item.getPosition(), item.getRotationType());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void runPortfolioTest() {
+    bool passed = true;
+    for (const PackJob& job : makeJobs(6)) {
+        Packer base;
+        for (const auto& bin : job.bins) base.addBin(bin);
+        for (const auto& item : job.items) base.addItem(item);
+
+        Packer greedy(base);
+        greedy.pack();
+
+        PortfolioOptions options;
+        options.runs = 7;
+        options.seed = 11;
+        options.threads = 1;
+        Packer serial(base);
+        PortfolioResult serial_result = packPortfolio(serial, options);
+        options.threads = 4;
+        Packer parallel(base);
+        PortfolioResult parallel_result = packPortfolio(parallel, options);
+
+        // Same winner whatever the thread count, and never worse than the default order
+        passed = passed && serial_result.best == parallel_result.best && layout(serial) == layout(parallel);
+        passed = passed && serial_result.runs[0].order == ItemOrder::VOLUME;
+        passed = passed && serial_result.runs[0].packed_volume == packedVolume(greedy);
+        passed = passed && packedVolume(serial) >= packedVolume(greedy);
+        passed = passed && packedVolume(serial) == serial_result.runs[serial_result.best].packed_volume;
+
+        // A custom objective that prefers the default order picks run 0
+        options.score = [](const Packer&) { return 0.0; };
+        Packer custom(base);
+        passed = passed && packPortfolio(custom, options).best == 0 && layout(custom) == layout(greedy);
+    }
+
+    // An expired budget still leaves a consistent packer behind
+    PackJob job = makeJobs(1)[0];
+    Packer rushed;
+    for (const auto& bin : job.bins) rushed.addBin(bin);
+    for (const auto& item : job.items) rushed.addItem(item);
+    PortfolioOptions options;
+    options.budget = std::chrono::milliseconds(0);
+    PortfolioResult result = packPortfolio(rushed, options);
+    passed = passed && result.runs.size() == options.runs && packedVolume(rushed) == result.runs[result.best].packed_volume;
+
+    // Each fixed order runs once; the rest are random orders with seeds of their own
+    for (std::size_t a = 0; a < result.runs.size(); ++a) {
+        for (std::size_t b = a + 1; b < result.runs.size(); ++b) {
+            const PortfolioRun& x = result.runs[a];
+            const PortfolioRun& y = result.runs[b];
+            passed = passed && (x.order != y.order || (x.order == ItemOrder::RANDOM && x.seed != y.seed));
+        }
+    }
+
+    std::cout << "Portfolio picks the best order deterministically: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runItemTypeTest() {
+    // The same order as SKUs with quantities and as one Item per box
+    Packer by_type;
+    Packer by_item;
+    for (Packer* packer : {&by_type, &by_item}) {
+        packer->addBin(Bin("Bin", 100, 100, 100));
+    }
+    std::size_t cube = by_type.addItemType(Item("Cube", 50, 50, 50, {RotationType::whd}), 3);
+    std::size_t slab = by_type.addItemType(Item("Slab", 100, 10, 100, {RotationType::whd}), 2);
+    by_type.addItemType(Item("Cube", 50, 50, 50, {RotationType::whd}), 7);
+    for (int i = 0; i < 10; ++i) {
+        by_item.addItem(Item("Cube", 50, 50, 50, {RotationType::whd}));
+    }
+    for (int i = 0; i < 2; ++i) {
+        by_item.addItem(Item("Slab", 100, 10, 100, {RotationType::whd}));
+    }
+    by_type.pack();
+    by_item.pack();
+
+    bool passed = by_type.getItemTypes().size() == 2 && by_type.getItemTypes()[cube].quantity == 10;
+    passed = passed && layout(by_type) == layout(by_item);
+    std::vector<std::size_t> packed = by_type.getPackedQuantities();
+    passed = passed && packed[cube] + packed[slab] == by_type.getBins()[0].getItems().size();
+    passed = passed && packed[cube] + packed[slab] + by_type.getUnfitItems().size() == 12;
+
+    // A SKU name cannot be reused for another box
+    bool rejected = false;
+    try {
+        by_type.addItemType(Item("Cube", 40, 50, 50, {RotationType::whd}), 1);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    passed = passed && rejected && by_type.getItemTypes()[cube].quantity == 10;
+
+    std::cout << "SKU quantities pack like one item per box: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// Every item of the packer is either in a bin or in unfit_items
+static bool everyItemAccounted(const Packer& packer) {
+    std::set<std::string> seen;
+    for (const auto& bin : packer.getBins()) {
+        for (const auto& ref : bin.getItems()) {
+            seen.insert(ref.get().getName());
+        }
+    }
+    for (const auto& item : packer.getUnfitItems()) {
+        seen.insert(item.getName());
+    }
+    for (const auto& item : packer.getItems()) {
+        if (!seen.count(item.getName())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every item of the packer is in exactly one bin or in unfit_items, once
+static bool everyItemAccountedOnce(const Packer& packer) {
+    std::map<std::string, std::size_t> seen;
+    for (const auto& bin : packer.getBins()) {
+        for (const auto& ref : bin.getItems()) {
+            ++seen[ref.get().getName()];
+        }
+    }
+    for (const auto& item : packer.getUnfitItems()) {
+        ++seen[item.getName()];
+    }
+    return seen.size() == packer.getItems().size() &&
+           std::all_of(seen.begin(), seen.end(), [](const auto& entry) { return entry.second == 1; });
+}
+
+// No two items of a bin overlap and every item lies inside its bin
+static bool layoutIsValid(const Packer& packer) {
+    for (const auto& bin : packer.getBins()) {
+        const auto& items = bin.getItems();
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            const ItemGeometry a = items[i].get().getGeometry();
+            if (a.position[0] + a.dimension[0] > bin.getWidth() || a.position[1] + a.dimension[1] > bin.getHeight() ||
+                a.position[2] + a.dimension[2] > bin.getDepth()) {
+                return false;
+            }
+            for (std::size_t j = i + 1; j < items.size(); ++j) {
+                if (a.intersects(items[j].get().getGeometry())) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void runWallTest() {
+    // Dominoes on a 5 x 5 face: a 5 x 4 block standing up and a row lying down
+    std::vector<FaceCell> cells = guillotinePattern(5, 5, 1, 2, true);
+    bool passed = cells.size() == 12;
+    for (std::size_t i = 0; i < cells.size() && passed; ++i) {
+        ItemGeometry a{{cells[i].turned ? 2L : 1L, cells[i].turned ? 1L : 2L, 1}, {cells[i].x, cells[i].y, 0}, RotationType::whd, 0};
+        passed = a.position[0] + a.dimension[0] <= 5 && a.position[1] + a.dimension[1] <= 5;
+        for (std::size_t j = 0; j < i && passed; ++j) {
+            ItemGeometry b{{cells[j].turned ? 2L : 1L, cells[j].turned ? 1L : 2L, 1}, {cells[j].x, cells[j].y, 0}, RotationType::whd, 0};
+            passed = !a.intersects(b);
+        }
+    }
+
+    // The trailer load of src/hello.py, item by item and in walls
+    std::size_t packed[2] = {0, 0};
+    const PackStrategy strategies[2] = {PackStrategy::ITEM_BY_ITEM, PackStrategy::WALLS};
+    for (int s = 0; s < 2; ++s) {
+        Packer packer;
+        packer.addBin(Bin("Trailer", 2500, 2650, 13600));
+        packer.addItemType(Item("Bag", 500, 400, 300), 80);
+        packer.addItemType(Item("Sack", 1000, 450, 300), 100);
+        packer.addItemType(Item("Box", 1000, 1000, 1000), 150);
+        PackOptions options;
+        options.strategy = strategies[s];
+        packer.setOptions(options);
+        packer.pack();
+        packed[s] = packer.getBins()[0].getItems().size();
+        passed = passed && layoutIsValid(packer) && everyItemAccounted(packer);
+    }
+    passed = passed && packed[1] >= packed[0];
+
+    std::cout << "Walls fill layers without overlaps: " << (passed ? "PASSED" : "FAILED")
+              << " (" << packed[0] << " item by item, " << packed[1] << " in walls)" << std::endl;
+}
+
+void runPalletTest() {
+    // 200 identical cartons onto a pallet, with and without the fast path
+    auto load = [](Packer& packer, const PackOptions& options) {
+        packer.addBin(Bin("Pallet", 1200, 1500, 800, 1000.0f));
+        for (int i = 0; i < 200; ++i) {
+            packer.addItem(Item("Carton " + std::to_string(i), 300, 200, 250, {RotationType::whd, RotationType::dhw}, "brown", 6.0f));
+        }
+        packer.setOptions(options);
+        packer.pack();
+    };
+
+    PackOptions options;
+    options.identical_fast_path = false;
+    Packer searched;
+    load(searched, options);
+
+    options.identical_fast_path = true;
+    options.pallet_patterns = std::make_shared<PalletPatternCache>(4);
+    Packer fast;
+    load(fast, options);
+    Packer again;
+    load(again, options);
+
+    bool passed = layoutIsValid(fast) && everyItemAccounted(fast) && layout(fast) == layout(again);
+    passed = passed && fast.getBins()[0].getItems().size() >= searched.getBins()[0].getItems().size();
+    passed = passed && fast.getBins()[0].getTotalWeight() <= 1000.0f;
+    passed = passed && options.pallet_patterns->misses() == 1 && options.pallet_patterns->hits() == 1;
+
+    // A cache loaded from a saved one answers without solving
+    const std::string path = "pallet_patterns_test.txt";
+    passed = passed && options.pallet_patterns->save(path);
+    options.pallet_patterns = std::make_shared<PalletPatternCache>(4);
+    passed = passed && options.pallet_patterns->load(path) && options.pallet_patterns->size() == 1;
+    std::remove(path.c_str());
+    Packer loaded;
+    load(loaded, options);
+    passed = passed && options.pallet_patterns->hits() == 1 && options.pallet_patterns->misses() == 0;
+    passed = passed && layout(loaded) == layout(fast);
+
+    std::cout << "Identical boxes load as a cached pallet pattern: " << (passed ? "PASSED" : "FAILED")
+              << " (" << fast.getBins()[0].getItems().size() << " stacked, "
+              << searched.getBins()[0].getItems().size() << " searched)" << std::endl;
+}
+
+void runResultCacheTest() {
+    PackJob job = makeJobs(3)[2];
+    PackOptions options;
+    options.result_cache = std::make_shared<PackResultCache>(1);
+    auto pack = [&options](const PackJob& order) {
+        Packer packer;
+        for (const auto& bin : order.bins) {
+            packer.addBin(bin);
+        }
+        for (const auto& item : order.items) {
+            packer.addItem(item);
+        }
+        packer.setOptions(options);
+        packer.pack();
+        return packer;
+    };
+    auto placedCount = [](const Packer& packer) {
+        std::size_t count = 0;
+        for (const auto& bin : packer.getBins()) {
+            count += bin.getItems().size();
+        }
+        return count;
+    };
+
+    Packer first = pack(job);
+
+    // The same shapes under other names and colours, added in reverse
+    PackJob renamed = job;
+    std::reverse(renamed.items.begin(), renamed.items.end());
+    for (std::size_t i = 0; i < renamed.items.size(); ++i) {
+        renamed.items[i].name = "Renamed " + std::to_string(i);
+        renamed.items[i].color = "blue";
+    }
+    Packer replayed = pack(renamed);
+    bool passed = options.result_cache->misses() == 1 && options.result_cache->hits() == 1;
+    passed = passed && layoutIsValid(replayed) && everyItemAccounted(replayed);
+    passed = passed && placedCount(replayed) == placedCount(first) && replayed.getUnfitItems().size() == first.getUnfitItems().size();
+
+    // A snapshot keeps the cache warm for a new process
+    const std::string path = "pack_results_test.txt";
+    passed = passed && options.result_cache->save(path);
+    options.result_cache = std::make_shared<PackResultCache>(1);
+    passed = passed && options.result_cache->load(path) && options.result_cache->size() == 1;
+    std::remove(path.c_str());
+    Packer restored = pack(job);
+    passed = passed && options.result_cache->hits() == 1 && layout(restored) == layout(first);
+
+    // Another shape misses and, with room for one entry, replaces the first
+    PackJob changed = job;
+    changed.items[0].width += 1;
+    pack(changed);
+    passed = passed && options.result_cache->misses() == 1 && options.result_cache->size() == 1;
+
+    // The same order under other placement options is packed afresh
+    const std::size_t misses = options.result_cache->misses();
+    options.best_fit = true;
+    pack(changed);
+    options.best_fit = false;
+    options.placement = PlacementModel::MAXIMAL_SPACES;
+    pack(changed);
+    options.placement = PlacementModel::EXTREME_POINTS;
+    options.min_support = 0.75f;
+    pack(changed);
+    passed = passed && options.result_cache->misses() == misses + 3 && options.result_cache->hits() == 1;
+
+    std::cout << "Results are replayed for orders of the same shape: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runPackOptionsTest() {
+    // Four bins of eight cubes each, so pack() needs several rounds
+    auto fill = [](Packer& packer) {
+        for (int i = 0; i < 4; ++i) {
+            packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+        }
+        for (int i = 0; i < 40; ++i) {
+            packer.addItem(Item("Cube " + std::to_string(i), 50, 50, 50, {RotationType::whd}));
+        }
+    };
+
+    // Progress only grows and the last report covers every item
+    Packer tracked;
+    fill(tracked);
+    std::vector<PackProgress> reports;
+    PackOptions options;
+    options.progress = [&reports](const PackProgress& progress) { reports.push_back(progress); };
+    tracked.setOptions(options);
+    tracked.pack();
+    bool passed = !reports.empty() && tracked.getStopReason() == PackStop::FINISHED;
+    for (std::size_t i = 1; i < reports.size(); ++i) {
+        passed = passed && reports[i].items_placed + reports[i].items_unfit >= reports[i - 1].items_placed + reports[i - 1].items_unfit;
+    }
+    passed = passed && reports.back().items_placed == 32 && reports.back().items_unfit == 8;
+    passed = passed && reports.back().bins_opened == 4 && reports.back().fill_rate == 1;
+
+    // Cancelling from the first report stops the pack with everything accounted for
+    Packer cancelled;
+    fill(cancelled);
+    CancelToken token;
+    options.cancel = token;
+    options.progress = [token](const PackProgress&) mutable { token.cancel(); };
+    cancelled.setOptions(options);
+    cancelled.pack();
+    passed = passed && cancelled.getStopReason() == PackStop::CANCELLED && everyItemAccounted(cancelled);
+    passed = passed && cancelled.getProgress().items_placed == 8 && cancelled.getUnfitItems().size() == 32;
+
+    // A spent time limit packs nothing and leaves every item unfit
+    Packer expired;
+    fill(expired);
+    options = PackOptions();
+    options.time_limit = std::chrono::milliseconds(-1);
+    expired.setOptions(options);
+    expired.pack();
+    passed = passed && expired.getStopReason() == PackStop::DEADLINE;
+    passed = passed && expired.getUnfitItems().size() == 40 && everyItemAccounted(expired);
+
+    // A limit running out while packToBin hands the rest to a bigger bin
+    // leaves no item both placed and unfit
+    for (long limit = 1; limit <= 4; ++limit) {
+        Packer mixed;
+        for (int i = 0; i < 12; ++i) {
+            const long edge = 40 + 10 * (i % 7);
+            mixed.addBin(Bin("Bin " + std::to_string(i), edge, edge, edge));
+        }
+        std::mt19937 rng(static_cast<uint32_t>(limit));
+        std::uniform_int_distribution<long> edge(5, 30);
+        for (int i = 0; i < 2000; ++i) {
+            mixed.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        options = PackOptions();
+        options.time_limit = std::chrono::milliseconds(limit);
+        mixed.setOptions(options);
+        mixed.pack();
+        passed = passed && everyItemAccountedOnce(mixed) && layoutIsValid(mixed);
+    }
+
+    std::cout << "Packing stops on deadline and cancel with a consistent result: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runOnlineTest() {
+    // Cubes arriving one at a time into two bins of eight each
+    Packer packer;
+    packer.addBin(Bin("Bin 0", 100, 100, 100));
+    packer.addBin(Bin("Bin 1", 100, 100, 100));
+    std::vector<std::pair<const Item*, std::tuple<long, long, long>>> placed;
+    std::size_t unfit = 0;
+    bool passed = true;
+    for (int i = 0; i < 20; ++i) {
+        std::optional<OnlinePlacement> placement = packer.placeNext(Item("Cube " + std::to_string(i), 50, 50, 50));
+        passed = passed && placement && placement->item == &packer.getOnlineItems().back();
+        if (placement && placement->bin) {
+            placed.emplace_back(placement->item, placement->item->getPosition());
+        } else {
+            ++unfit;
+        }
+        // Earlier arrivals stay where they were put
+        for (const auto& [item, position] : placed) {
+            passed = passed && item->getPosition() == position;
+        }
+    }
+    passed = passed && placed.size() == 16 && unfit == 4 && packer.getUnfitItems().size() == 4;
+    passed = passed && layoutIsValid(packer);
+
+    // With look-ahead the large box is committed before the small ones ahead of it
+    Packer buffered;
+    PackOptions options;
+    options.lookahead = 2;
+    buffered.setOptions(options);
+    buffered.addBin(Bin("Bin", 100, 100, 100));
+    passed = passed && !buffered.placeNext(Item("Small 0", 10, 10, 10));
+    passed = passed && !buffered.placeNext(Item("Small 1", 10, 10, 10));
+    std::optional<OnlinePlacement> first = buffered.placeNext(Item("Large", 100, 100, 90));
+    passed = passed && first && first->bin && first->item->getName() == "Large";
+    std::vector<OnlinePlacement> rest = buffered.flushOnline();
+    passed = passed && rest.size() == 2 && rest[0].bin && rest[1].bin && layoutIsValid(buffered);
+    passed = passed && buffered.flushOnline().empty();
+
+    // Points passed over for a thick arrival stay open to a thinner one: the
+    // slab fits nowhere beside the cube, but the small cube still does
+    Packer thinning;
+    thinning.addBin(Bin("Bin", 100, 100, 100));
+    std::optional<OnlinePlacement> thick = thinning.placeNext(Item("Thick", 60, 60, 60));
+    std::optional<OnlinePlacement> slab = thinning.placeNext(Item("Slab", 100, 50, 100));
+    std::optional<OnlinePlacement> thin = thinning.placeNext(Item("Thin", 30, 30, 30));
+    passed = passed && thick && thick->bin && slab && !slab->bin && thin && thin->bin;
+    passed = passed && thinning.getUnfitItems().size() == 1 && layoutIsValid(thinning);
+
+    std::cout << "Online items are placed as they arrive without moving earlier ones: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runRepackTest() {
+    // A packed order of mixed boxes over three bins
+    Packer packer;
+    for (int i = 0; i < 3; ++i) {
+        packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+    }
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<long> edge(10, 40);
+    for (int i = 0; i < 120; ++i) {
+        packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+    }
+    packer.pack();
+    const PackResult previous = packer.getResult();
+    std::vector<std::tuple<long, long, long>> poses;
+    for (const auto& item : packer.getItems()) {
+        poses.push_back(item.getPosition());
+    }
+
+    // Take out two placed boxes and the first unfit one, and add two new ones
+    OrderDelta delta;
+    delta.removed = {previous.placements[0].item, previous.placements[5].item};
+    if (!previous.unfit.empty()) {
+        delta.removed.push_back(previous.unfit[0]);
+    }
+    delta.added = {Item("New 0", 20, 20, 20), Item("New 1", 30, 10, 20)};
+    std::vector<bool> removed(packer.getItems().size(), false);
+    for (std::size_t index : delta.removed) {
+        removed[index] = true;
+    }
+    std::vector<bool> was_placed(packer.getItems().size(), false);
+    for (const auto& placement : previous.placements) {
+        was_placed[placement.item] = true;
+    }
+
+    bool passed = packer.repack(previous, delta);
+    const std::size_t kept_count = previous.placements.size() + previous.unfit.size() - delta.removed.size();
+    passed = passed && packer.getItems().size() == kept_count + 2;
+    passed = passed && layoutIsValid(packer) && everyItemAccounted(packer);
+
+    // Kept placements stay put
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < poses.size() && passed; ++i) {
+        if (removed[i]) {
+            continue;
+        }
+        passed = !was_placed[i] || packer.getItems()[next].getPosition() == poses[i];
+        ++next;
+    }
+    passed = passed && packer.getResult().placements.size() >= previous.placements.size() - 2;
+
+    // Out of range references change nothing
+    OrderDelta bad;
+    bad.removed = {packer.getItems().size()};
+    passed = passed && !packer.repack(packer.getResult(), bad) && layoutIsValid(packer);
+
+    std::cout << "Repacking a changed order keeps earlier placements: " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+void runMaximalSpacesTest() {
+    // A slab down the left half, then a block in the bottom of the right half
+    MaximalSpaceSet spaces;
+    spaces.clear({10, 10, 10});
+    spaces.push({{0, 0, 0}, {5, 10, 10}});
+    bool passed = spaces.size() == 1 && spaces.spaces()[0].min == std::array<long, 3>{5, 0, 0};
+    spaces.push({{5, 0, 0}, {10, 5, 5}});
+    const std::vector<GridBox> after_two = spaces.spaces();
+    passed = passed && spaces.size() == 2;
+    std::optional<GridBox> best = spaces.best({5, 5, 10});
+    passed = passed && best && best->min == std::array<long, 3>{5, 5, 0};
+    passed = passed && !spaces.best({6, 1, 1}) && !spaces.best({5, 6, 6});
+    spaces.push({{5, 5, 0}, {10, 10, 5}});
+    spaces.pop();
+    passed = passed && spaces.size() == after_two.size();
+    for (std::size_t i = 0; i < after_two.size() && passed; ++i) {
+        passed = spaces.spaces()[i].min == after_two[i].min && spaces.spaces()[i].max == after_two[i].max;
+    }
+    spaces.pop();
+    spaces.pop();
+    passed = passed && spaces.size() == 1 && spaces.spaces()[0].max == std::array<long, 3>{10, 10, 10};
+
+    // More boxes than fit, under both placement models
+    long packed_volume[2] = {0, 0};
+    for (int model = 0; model < 2; ++model) {
+        Packer packer;
+        for (int i = 0; i < 3; ++i) {
+            packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+        }
+        std::mt19937 rng(8);
+        std::uniform_int_distribution<long> edge(10, 40);
+        for (int i = 0; i < 300; ++i) {
+            packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        PackOptions options;
+        options.placement = model == 0 ? PlacementModel::EXTREME_POINTS : PlacementModel::MAXIMAL_SPACES;
+        packer.setOptions(options);
+        packer.pack();
+        passed = passed && layoutIsValid(packer) && everyItemAccounted(packer);
+        for (const auto& bin : packer.getBins()) {
+            packed_volume[model] += bin.getUsedVolume();
+            // No free space overlaps a placed box
+            for (const GridBox& space : bin.getFreeSpaces().spaces()) {
+                const ItemGeometry free{{space.max[0] - space.min[0], space.max[1] - space.min[1], space.max[2] - space.min[2]},
+                                        space.min, RotationType::whd, 0.0f};
+                passed = passed && !bin.intersectsPlacedItem(free);
+            }
+        }
+    }
+    passed = passed && packed_volume[1] >= packed_volume[0];
+
+    std::cout << "Maximal spaces track the free room and place items in it: " << (passed ? "PASSED" : "FAILED")
+              << " (" << packed_volume[0] << " on extreme points, " << packed_volume[1] << " in maximal spaces)" << std::endl;
+}
+
+// Share of the item's base resting on tops of other items in the bin, by a pairwise scan
+static double exactSupport(const Bin& bin, const Item& item) {
+    const ItemGeometry a = item.getGeometry();
+    long area = 0;
+    for (const auto& ref : bin.getItems()) {
+        const ItemGeometry b = ref.get().getGeometry();
+        if (&ref.get() == &item || b.position[1] + b.dimension[1] != a.position[1]) {
+            continue;
+        }
+        long w = std::min(a.position[0] + a.dimension[0], b.position[0] + b.dimension[0]) - std::max(a.position[0], b.position[0]);
+        long d = std::min(a.position[2] + a.dimension[2], b.position[2] + b.dimension[2]) - std::max(a.position[2], b.position[2]);
+        area += std::max(0L, w) * std::max(0L, d);
+    }
+    return static_cast<double>(area) / (a.dimension[0] * a.dimension[2]);
+}
+
+void runHeightMapTest() {
+    // A 5 x 4 x 10 block on a 10 x 10 floor
+    HeightMap heights;
+    heights.reset(10, 10, 1);
+    heights.push({{0, 0, 0}, {5, 4, 10}});
+    bool passed = heights.restingHeight(3, 0, 4, 4) == 4 && heights.restingHeight(5, 0, 5, 10) == 0;
+    passed = passed && heights.supportedFraction(3, 4, 0, 4, 4) == 0.5 && heights.supportedFraction(0, 4, 0, 5, 10) == 1.0;
+    heights.pop();
+    passed = passed && heights.restingHeight(0, 0, 10, 10) == 0 && heights.depth() == 0;
+
+    // Coarse cells count a partly covered cell as covered
+    heights.reset(10, 10, 5);
+    heights.push({{0, 0, 0}, {3, 2, 3}});
+    passed = passed && heights.restingHeight(4, 4, 1, 1) == 2 && heights.restingHeight(5, 0, 5, 5) == 0;
+
+    // With a minimum support ratio no box stands on less than that
+    std::size_t floating[2] = {0, 0};
+    for (int run = 0; run < 2; ++run) {
+        Packer packer;
+        for (int i = 0; i < 3; ++i) {
+            packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+        }
+        std::mt19937 rng(8);
+        std::uniform_int_distribution<long> edge(10, 40);
+        for (int i = 0; i < 300; ++i) {
+            packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        PackOptions options;
+        options.min_support = run == 0 ? 0.0f : 0.75f;
+        options.support_cell = 1;
+        packer.setOptions(options);
+        packer.pack();
+        passed = passed && layoutIsValid(packer) && everyItemAccounted(packer);
+        for (const auto& bin : packer.getBins()) {
+            for (const auto& ref : bin.getItems()) {
+                if (std::get<1>(ref.get().getPosition()) > 0 && exactSupport(bin, ref.get()) < 0.75) {
+                    ++floating[run];
+                }
+            }
+        }
+    }
+    passed = passed && floating[0] > 0 && floating[1] == 0;
+
+    std::cout << "Height maps keep boxes supported: " << (passed ? "PASSED" : "FAILED")
+              << " (" << floating[0] << " boxes under-supported without a minimum)" << std::endl;
+}
+
+void runBestFitTest() {
+    // A board stood up, then laid flat by best fit
+    bool passed = true;
+    for (int run = 0; run < 2; ++run) {
+        Packer packer;
+        packer.addBin(Bin("Bin", 10, 10, 10));
+        packer.addItem(Item("Board", 10, 10, 2));
+        PackOptions options;
+        options.best_fit = run == 1;
+        packer.setOptions(options);
+        packer.pack();
+        const ItemGeometry board = packer.getItems()[0].getGeometry();
+        passed = passed && packer.getUnfitItems().empty() && (run == 0 || board.dimension[1] == 2);
+    }
+
+    // More boxes than fit, first fit against best fit
+    long packed_volume[2] = {0, 0};
+    for (int run = 0; run < 2; ++run) {
+        Packer packer;
+        for (int i = 0; i < 3; ++i) {
+            packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+        }
+        std::mt19937 rng(8);
+        std::uniform_int_distribution<long> edge(10, 40);
+        for (int i = 0; i < 300; ++i) {
+            packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        PackOptions options;
+        options.best_fit = run == 1;
+        packer.setOptions(options);
+        packer.pack();
+        passed = passed && layoutIsValid(packer) && everyItemAccounted(packer);
+        for (const auto& bin : packer.getBins()) {
+            packed_volume[run] += bin.getUsedVolume();
+        }
+    }
+    passed = passed && packed_volume[1] > packed_volume[0];
+
+    // With a support minimum every pose is lowered, and the pick is still the
+    // best one over all candidates, as an exhaustive scan finds it
+    {
+        Packer packer;
+        packer.addBin(Bin("Bin", 100, 100, 100));
+        std::mt19937 rng(27);
+        std::uniform_int_distribution<long> edge(10, 40);
+        for (int i = 0; i < 60; ++i) {
+            packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        PackOptions options;
+        options.best_fit = true;
+        options.min_support = 0.75f;
+        packer.setOptions(options);
+        Bin& bin = packer.bins[0];
+        auto score = [](const ItemGeometry& pose) {
+            return 4 * (pose.position[1] + pose.dimension[1]) + 2 * (pose.position[2] + pose.dimension[2]) +
+                   (pose.position[0] + pose.dimension[0]);
+        };
+        for (Item& item : packer.items) {
+            long expected = std::numeric_limits<long>::max();
+            bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& candidate) {
+                for (const Orientation& orientation : bin.getOrientations(item)) {
+                    const auto& d = orientation.dimension;
+                    const long x = std::get<0>(candidate);
+                    const long z = std::get<2>(candidate);
+                    if (x + d[0] > 100 || std::get<1>(candidate) + d[1] > 100 || z + d[2] > 100) {
+                        continue;
+                    }
+                    const long y = std::min(std::get<1>(candidate),
+                                            bin.getHeightMap(options.support_cell).restingHeight(x, z, d[0], d[2]));
+                    const ItemGeometry pose = item.getGeometry(orientation.rotation, {x, y, z});
+                    if (!bin.intersectsPlacedItem(pose) &&
+                        (y == 0 || bin.getHeightMap(options.support_cell).supportedFraction(x, y, z, d[0], d[2]) >= 0.75)) {
+                        expected = std::min(expected, score(pose));
+                    }
+                }
+                return false;
+            });
+            const bool placed = packer.placeItem(bin, item, true);
+            passed = passed && placed == (expected != std::numeric_limits<long>::max()) &&
+                     (!placed || score(item.getGeometry()) == expected);
+        }
+        passed = passed && layoutIsValid(packer);
+    }
+
+    std::cout << "Best fit weighs every pose and packs denser: " << (passed ? "PASSED" : "FAILED")
+              << " (" << packed_volume[0] << " first fit, " << packed_volume[1] << " best fit)" << std::endl;
+}
+
+void runLocalSearchTest() {
+    // More boxes than fit; improve the greedy result without undoing any of it
+    bool passed = true;
+    double packed_volume[2] = {0, 0};
+    std::size_t accepted[2] = {0, 0};
+    for (int run = 0; run < 2; ++run) {
+        Packer packer;
+        for (int i = 0; i < 3; ++i) {
+            packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+        }
+        std::mt19937 rng(21);
+        std::uniform_int_distribution<long> edge(10, 40);
+        for (int i = 0; i < 300; ++i) {
+            packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        PackOptions options;
+        options.min_support = run == 1 ? 0.75 : 0;
+        packer.setOptions(options);
+        packer.pack();
+
+        ImproveOptions improve;
+        improve.budget = std::chrono::milliseconds(2000);
+        improve.seed = 3;
+        ImproveResult result = improvePacking(packer, improve);
+        passed = passed && layoutIsValid(packer) && everyItemAccounted(packer) &&
+                 result.packed_volume_after >= result.packed_volume_before &&
+                 result.bins_used_after <= result.bins_used_before &&
+                 result.packed_volume_after == packedVolume(packer);
+        packed_volume[run] = result.packed_volume_after - result.packed_volume_before;
+        accepted[run] = result.accepted;
+    }
+    passed = passed && packed_volume[0] > 0 && packed_volume[1] > 0;
+
+    // Two half-full bins empty into one
+    {
+        Packer packer;
+        packer.addBin(Bin("Small", 10, 10, 10));
+        packer.addBin(Bin("Large", 20, 10, 10));
+        packer.addItem(Item("Left", 10, 10, 10));
+        packer.addItem(Item("Right", 10, 10, 10));
+        packer.pack();
+        const std::size_t before = binsUsed(packer);
+        ImproveOptions improve;
+        improve.objective = PortfolioObjective::BINS_USED;
+        improvePacking(packer, improve);
+        passed = passed && before == 2 && binsUsed(packer) == 1 && packer.getUnfitItems().empty() &&
+                 layoutIsValid(packer);
+    }
+
+    std::cout << "Local search improves a packed result: " << (passed ? "PASSED" : "FAILED")
+              << " (+" << static_cast<long>(packed_volume[0]) << " volume in " << accepted[0] << " moves, +"
+              << static_cast<long>(packed_volume[1]) << " with a support minimum)" << std::endl;
+}
+
+void runBrkgaTest() {
+    // More boxes than fit, each a few ways up; the greedy order seeds the search
+    auto makePacker = []() {
+        Packer packer;
+        for (int i = 0; i < 2; ++i) {
+            packer.addBin(Bin("Bin " + std::to_string(i), 100, 100, 100));
+        }
+        std::mt19937 rng(25);
+        std::uniform_int_distribution<long> edge(10, 50);
+        for (int i = 0; i < 80; ++i) {
+            packer.addItem(Item("Box " + std::to_string(i), edge(rng), edge(rng), edge(rng)));
+        }
+        return packer;
+    };
+    Packer greedy = makePacker();
+    greedy.pack();
+
+    BrkgaOptions options;
+    options.population = 24;
+    options.generations = 15;
+    options.budget = std::chrono::milliseconds(60000);
+    options.seed = 7;
+    std::size_t logged = 0;
+    options.on_generation = [&logged](const BrkgaGeneration&) { ++logged; };
+
+    bool passed = true;
+    double packed_volume[2] = {0, 0};
+    std::vector<double> keys[2];
+    for (int run = 0; run < 2; ++run) {
+        Packer packer = makePacker();
+        options.threads = run == 0 ? 1 : 4;
+        BrkgaResult result = packBrkga(packer, options);
+        passed = passed && layoutIsValid(packer) && everyItemAccounted(packer) &&
+                 result.packed_volume == packedVolume(packer) && result.log.size() == result.generations + 1;
+        for (std::size_t g = 1; g < result.log.size(); ++g) {
+            passed = passed && result.log[g].best_packed_volume >= result.log[g - 1].best_packed_volume;
+        }
+        packed_volume[run] = result.packed_volume;
+        keys[run] = result.best_keys;
+    }
+    // Same seed, same result on any number of threads
+    passed = passed && packed_volume[0] == packed_volume[1] && keys[0] == keys[1] && logged == 32 &&
+             packed_volume[0] > packedVolume(greedy);
+
+    // A cancelled search hands back what it decoded without packing again
+    Packer cancelled = makePacker();
+    PackOptions pack_options;
+    CancelToken token;
+    token.cancel();
+    pack_options.cancel = token;
+    cancelled.setOptions(pack_options);
+    options.on_generation = nullptr;
+    BrkgaResult stopped = packBrkga(cancelled, options);
+    passed = passed && stopped.generations == 0 && stopped.packed_volume == packedVolume(cancelled) &&
+             packedVolume(cancelled) < packedVolume(greedy) && layoutIsValid(cancelled) &&
+             everyItemAccounted(cancelled);
+
+    std::cout << "BRKGA beats the greedy order it starts from: " << (passed ? "PASSED" : "FAILED")
+              << " (" << static_cast<long>(packedVolume(greedy)) << " greedy, "
+              << static_cast<long>(packed_volume[0]) << " after " << options.generations << " generations)" << std::endl;
+}
+
+// Jobs per second of the batch service for a growing number of workers
+void runPackServiceBenchmark(std::size_t job_count) {
+    std::vector<PackJob> jobs = makeJobs(job_count);
+    std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t workers = 1; ; workers = std::min(workers * 2, cores)) {
+        PackService service(workers);
+        auto start = std::chrono::steady_clock::now();
+        service.packBatch(jobs, [](std::size_t, PackResult) {});
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << workers << " workers: " << static_cast<long>(job_count / seconds) << " jobs/sec" << std::endl;
+        if (workers == cores) {
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--bench-service") {
+        runPackServiceBenchmark(argc > 2 ? std::stoul(argv[2]) : 2000);
+        return 0;
+    }
+
     std::vector<std::tuple<std::string, std::vector<Bin>, std::vector<Item>, std::function<bool(const Packer&)>>> testDatas = {
         {
             "Edge case that needs rotation.",
@@ -98,5 +1381,28 @@ long main() {
         runTest(name, bins, items, expectation);
     }
 
+    runAllocationTest();
+    runKernelTest();
+    runSupportGraphTest();
+    runBinTotalsTest();
+    runForkTest();
+    runBinProbeTest();
+    runOrientationTableTest();
+    runPackServiceTest();
+    runPackColumnsTest();
+    runPortfolioTest();
+    runItemTypeTest();
+    runPackOptionsTest();
+    runWallTest();
+    runPalletTest();
+    runResultCacheTest();
+    runOnlineTest();
+    runRepackTest();
+    runMaximalSpacesTest();
+    runHeightMapTest();
+    runBestFitTest();
+    runLocalSearchTest();
+    runBrkgaTest();
+
     return 0;
 }
@@ -11,7 +11,7 @@ import pybind11
 ext_modules = [
     Extension(
         'pybinding',
-        sources=['src/item.cpp', 'src/pybinding.cpp', 'src/box.cpp', 'src/bin.cpp', 'src/packer.cpp', 'src/utils.cpp', 'src/log.cpp'],
+        sources=['src/item.cpp', 'src/pybinding.cpp', 'src/box.cpp', 'src/bin.cpp', 'src/packer.cpp', 'src/utils.cpp', 'src/log.cpp', 'src/spatial_grid.cpp', 'src/extreme_points.cpp', 'src/placed_boxes.cpp', 'src/box_kernels.cpp', 'src/support_graph.cpp', 'src/bin_index.cpp', 'src/orientations.cpp', 'src/work_pool.cpp', 'src/pack_service.cpp', 'src/portfolio.cpp', 'src/pack_columns.cpp', 'src/wall_builder.cpp', 'src/pallet_patterns.cpp', 'src/result_cache.cpp', 'src/maximal_spaces.cpp', 'src/height_map.cpp', 'src/local_search.cpp', 'src/brkga.cpp'],
         include_dirs=["include", pybind11.get_include()],
         language='c++'
     ),
@@ -24,5 +24,5 @@ setup(
     author_email='vijaysinghkushwaha3737@gmail.com',
     description='A 3D bin packing library',
     ext_modules=ext_modules,
-    install_requires=['pybind11>=2.5.0'],
+    install_requires=['pybind11>=2.5.0', 'numpy'],
 )
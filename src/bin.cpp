@@ -1,75 +1,268 @@
 #include "bin.h"
+#include "box_kernels.h"
 #include <cmath>
 #include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <functional> 
 
+// Bins with at most this many items skip the grid for overlap tests
+const std::size_t LINEAR_SCAN_LIMIT = 32;
+
+GridBox itemBounds(const ItemGeometry& geometry) {
+    const auto& p = geometry.position;
+    const auto& d = geometry.dimension;
+    return GridBox{p, {p[0] + d[0], p[1] + d[1], p[2] + d[2]}};
+}
+
+GridBox itemBounds(const Item& item) {
+    return itemBounds(item.getGeometry());
+}
+
 Bin::Bin(const std::string& name, long w, long h, long d, float max_weight, const std::string& image, const std::string& description, int id) 
     : Box(name, w, h, d), max_weight(max_weight), image(image), description(description), id(id) {
 }
 
+void Bin::indexItem(std::size_t index) {
+    if (!grid.covers(width, height, depth) || grid.size() != index) {
+        // Dimensions changed behind our back, or the index lags, start over
+        rebuildIndex();
+        return;
+    }
+    const Item& item = items[index].get();
+    const auto geometry = item.getGeometry();
+    placed.push(geometry, placementFlags(item));
+    grid.insert(static_cast<uint32_t>(index), itemBounds(geometry));
+}
+
+void Bin::rebuildIndex() const {
+    grid.reset(width, height, depth);
+    placed.clear();
+    candidate_points.clear();
+    candidates_synced = 0;
+    spaces_synced = 0;
+    heights_synced = 0;
+    support.clear();
+    support_synced = 0;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const Item& item = items[i].get();
+        const auto geometry = item.getGeometry();
+        placed.push(geometry, placementFlags(item));
+        grid.insert(static_cast<uint32_t>(i), itemBounds(geometry));
+    }
+}
+
+const PlacedBoxes& Bin::getPlacedBoxes() const {
+    syncIndex();
+    return placed;
+}
+
+float Bin::getTotalWeight() const {
+    return getPlacedBoxes().total().weight;
+}
+
+long Bin::getUsedVolume() const {
+    return getPlacedBoxes().total().volume;
+}
+
+double Bin::getFillRatio() const {
+    long volume = getVolume();
+    return volume > 0 ? static_cast<double>(getUsedVolume()) / volume : 0.0;
+}
+
+GridBox Bin::getLoadBounds() const {
+    return getPlacedBoxes().total().bounds;
+}
+
+std::array<long, 3> Bin::getMaxOccupied() const {
+    return getPlacedBoxes().total().bounds.max;
+}
+
+std::array<double, 3> Bin::getCenterOfMass() const {
+    const PlacedTotals& total = getPlacedBoxes().total();
+    std::array<double, 3> center{0, 0, 0};
+    for (int axis = 0; axis < 3; ++axis) {
+        if (total.weight > 0) {
+            center[axis] = total.weight_moment[axis] / total.weight;
+        } else if (total.volume > 0) {
+            center[axis] = total.volume_moment[axis] / total.volume;
+        }
+    }
+    return center;
+}
+
+const SupportGraph& Bin::getSupportGraph() const {
+    syncSupport();
+    return support;
+}
+
+void Bin::syncIndex() const {
+    // The bin's dimensions are public and may change, so re-check before each query
+    if (grid.size() != items.size() || !grid.covers(width, height, depth)) {
+        rebuildIndex();
+    }
+}
+
+void Bin::retireCandidate(const std::tuple<long, long, long>& position) {
+    syncCandidates();
+    candidate_points.retire({std::get<0>(position), std::get<1>(position), std::get<2>(position)});
+}
+
+void Bin::blockCandidate(const std::tuple<long, long, long>& position, long edge) {
+    syncCandidates();
+    candidate_points.block({std::get<0>(position), std::get<1>(position), std::get<2>(position)}, edge);
+}
+
+void Bin::syncCandidates() const {
+    syncIndex();
+    for (; candidates_synced < items.size(); ++candidates_synced) {
+        uint32_t index = static_cast<uint32_t>(candidates_synced);
+        candidate_points.push(grid.boxOf(index), index, grid, {width, height, depth});
+    }
+}
+
+void Bin::syncSpaces() const {
+    syncIndex();
+    if (spaces_synced == 0) {
+        free_spaces.clear({width, height, depth});
+    }
+    for (; spaces_synced < items.size(); ++spaces_synced) {
+        free_spaces.push(grid.boxOf(static_cast<uint32_t>(spaces_synced)));
+    }
+}
+
+const MaximalSpaceSet& Bin::getFreeSpaces() const {
+    syncSpaces();
+    return free_spaces;
+}
+
+void Bin::syncHeights(long cell) const {
+    syncIndex();
+    if (heights_synced != height_map.depth() || !height_map.covers(width, depth, cell)) {
+        height_map.reset(width, depth, cell);
+        heights_synced = 0;
+    }
+    for (; heights_synced < items.size(); ++heights_synced) {
+        height_map.push(grid.boxOf(static_cast<uint32_t>(heights_synced)));
+    }
+}
+
+const HeightMap& Bin::getHeightMap(long cell) const {
+    syncHeights(cell);
+    return height_map;
+}
+
+void Bin::syncSupport() const {
+    syncIndex();
+    for (; support_synced < items.size(); ++support_synced) {
+        support.push(placed, grid);
+    }
+}
+
+bool Bin::intersectsPlacedItem(const ItemGeometry& geometry) const {
+    syncIndex();
+    GridBox box = itemBounds(geometry);
+
+    // A short list is cheaper to stream through than to look up cell by cell
+    if (placed.size() <= LINEAR_SCAN_LIMIT) {
+        return firstOverlap(placed, 0, placed.size(), box) != placed.size();
+    }
+    return grid.forEachInRegion(box, [this, &box](uint32_t index) {
+        return placed.overlaps(index, box);
+    });
+}
+
+bool Bin::intersectsPlacedItem(const Item& item) const {
+    return intersectsPlacedItem(item.getGeometry());
+}
+
 const std::vector<std::reference_wrapper<Item>>& Bin::getItems() const {
     return items;
 }
 
 void Bin::setItems(const std::vector<std::reference_wrapper<Item>>& new_items) {
     this->items = new_items;
+    rebuildIndex();
 }
 
 void Bin::addItem(Item& item) {
     items.push_back(std::ref(item));
+    indexItem(items.size() - 1);
+}
+
+void Bin::popItem() {
+    if (grid.size() != items.size()) {
+        // The index lags behind `items`, start over
+        items.pop_back();
+        rebuildIndex();
+        return;
+    }
+
+    // Only the latest item's cells, links and totals need undoing
+    if (items.size() == candidates_synced) {
+        candidate_points.pop();
+        --candidates_synced;
+    }
+    if (items.size() == spaces_synced) {
+        free_spaces.pop();
+        --spaces_synced;
+    }
+    if (items.size() == heights_synced) {
+        height_map.pop();
+        --heights_synced;
+    }
+    if (items.size() == support_synced) {
+        support.pop(placed);
+        --support_synced;
+    }
+    grid.remove(static_cast<uint32_t>(items.size() - 1));
+    placed.pop();
+    items.pop_back();
+}
+
+std::size_t Bin::checkpoint() const {
+    return items.size();
+}
+
+void Bin::rollback(std::size_t mark) {
+    while (items.size() > mark) {
+        popItem();
+    }
 }
 
 bool Bin::removeItem(Item& item) {
+    // Undoing the latest placement is the common case
+    if (!items.empty() && &items.back().get() == &item) {
+        popItem();
+        return true;
+    }
+
     auto it = std::find_if(items.begin(), items.end(), [&item](const std::reference_wrapper<Item>& ref) {
         return &ref.get() == &item;
     });
     
     if (it != items.end()) {
+        // Every later item shifts down one slot, so its grid id changes
         items.erase(it);
+        rebuildIndex();
         return true;
     }
     return false;
 }
 
 float Bin::scoreRotation(const Item& item, const std::tuple<long, long, long>& position, RotationType rotation_type) const {
-    Item rotatedItem = item;
-    rotatedItem.setRotationType(rotation_type);
-    auto d = rotatedItem.getDimension();
-
-    if (getWidth() < d[0] || getHeight() < d[1] || getDepth() < d[2]) {
-        return 0;
-    }
-    float widthScore = std::pow(static_cast<float>(d[0]) / getWidth(), 2);
-    float heightScore = std::pow(static_cast<float>(d[1]) / getHeight(), 2);
-    float depthScore = std::pow(static_cast<float>(d[2]) / getDepth(), 2);
+    auto d = rotateDimension(item.getWidth(), item.getHeight(), item.getDepth(), rotation_type);
+    return orientationScore(d, {width, height, depth});
+}
 
-    float score = widthScore + heightScore + depthScore;
-    return score;
+const OrientationTable& Bin::getOrientations(const Item& item) const {
+    return orientation_cache.lookup(item, {width, height, depth});
 }
 
-RotationType Bin::getBestRotationOrder(const Item& item, const std::tuple<long, long, long>& position) const {
-    // Use map to maintain same structure as Python dictionary
-    std::map<RotationType, float> rotationScores;
-    
-    // Score all rotation types
-    for (auto rotation : item.getAllowedRotations()) {
-        rotationScores[rotation] = scoreRotation(item, position, rotation);
-    }
-    
-    // Find rotation with highest score
-    RotationType bestRotation = item.getAllowedRotations()[0]; // Default to first allowed rotation
-    float bestScore = 0;
-    
-    for (const auto& [rotation, score] : rotationScores) {
-        if (score > bestScore) {
-            bestScore = score;
-            bestRotation = rotation;
-        }
-    }
-    
-    return bestRotation;
+RotationType Bin::getBestRotationOrder(const Item& item, const std::tuple<long, long, long>& /* position */) const {
+    // Highest score wins, lower RotationType on a tie; scores do not depend
+    // on the position, so the pick is cached with the item's orientations
+    return getOrientations(item).best;
 }
 
 bool Bin::putItem(Item& item, const std::tuple<long, long, long>& p) {
@@ -78,23 +271,18 @@ bool Bin::putItem(Item& item, const std::tuple<long, long, long>& p) {
 
     item.setPosition({std::get<0>(p), std::get<1>(p), std::get<2>(p)});
     item.setRotationType(bestRotation);
-    auto d = item.getDimension();
+    const auto geometry = item.getGeometry();
+    const auto& d = geometry.dimension;
 
     if (getWidth() < std::get<0>(p) + d[0] || 
         getHeight() < std::get<1>(p) + d[1] || 
         getDepth() < std::get<2>(p) + d[2]) {
         fit = false;
     } else {
-        fit = true;
-        for (const auto& otherItem : items) {
-            if (otherItem.get().doesIntersect(item)) {
-                fit = false;
-                break;
-            }
-        }
+        fit = !intersectsPlacedItem(geometry);
 
         if (fit) {
-            items.push_back(std::ref(item));
+            addItem(item);
         }
     }
 
@@ -102,8 +290,9 @@ bool Bin::putItem(Item& item, const std::tuple<long, long, long>& p) {
 }
 
 bool Bin::canItemFit(const Item& item, const std::tuple<long, long, long>& position) const {
-    // Get item dimensions 
-    const auto& item_dim = item.getDimension();
+    // Evaluate the pose on a plain geometry record rather than a copy of the item
+    const auto geometry = item.getGeometry(item.getRotationType(), position);
+    const auto& item_dim = geometry.dimension;
     
     // Check if the item fits within bin boundaries
     if (std::get<0>(position) + item_dim[0] > width ||
@@ -113,26 +302,16 @@ bool Bin::canItemFit(const Item& item, const std::tuple<long, long, long>& posit
     }
     
     // Check if item exceeds weight limit
-    float total_weight = 0.0f;
-    for (const auto& existing_item : items) {
-        total_weight += existing_item.get().weight;
-    }
-    
-    if (max_weight > 0 && total_weight + item.weight > max_weight) {
+    if (max_weight > 0 && getTotalWeight() + item.weight > max_weight) {
         return false;
     }
     
     // Check for intersections with existing items
-    Item temp_item = item;  // Create a temporary copy to check placement
-    temp_item.setPosition(position);
-    
-    for (const auto& existing_item : items) {
-        if (temp_item.doesIntersect(existing_item)) {
-            return false;
-        }
-    }
-    
-    return true;
+    return !intersectsPlacedItem(geometry);
+}
+
+uint8_t Bin::probe(const Item& item) const {
+    return getOrientations(item).fitting;
 }
 
 std::string Bin::toString() const {
@@ -8,10 +8,20 @@
 #include <tuple>
 #include "box.h"
 #include "item.h"
+#include "spatial_grid.h"
+#include "extreme_points.h"
+#include "maximal_spaces.h"
+#include "height_map.h"
+#include "placed_boxes.h"
+#include "support_graph.h"
+#include "orientations.h"
+
+// Box occupied by a pose, or by an item at its current position and rotation
+GridBox itemBounds(const ItemGeometry& geometry);
+GridBox itemBounds(const Item& item);
 
 class Bin : public Box {
 public:
-    std::vector<std::reference_wrapper<Item>> items;
     float max_weight;
     std::string image;
     std::string description;
@@ -24,9 +34,17 @@ public:
 
     // Function declarations
     const std::vector<std::reference_wrapper<Item>>& getItems() const;
+    // Replace the placed items and reindex them. The bin does not watch the
+    // poses of its items: after moving a placed one, call setItems(getItems()).
     void setItems(const std::vector<std::reference_wrapper<Item>>& new_items);
     void addItem(Item& item);
     bool removeItem(Item& item);
+
+    // Placements are undone latest first, so a checkpoint is just the number
+    // of items placed; rollback removes everything placed after it, O(1) per
+    // item. Item poses are left as they are, as with removeItem.
+    std::size_t checkpoint() const;
+    void rollback(std::size_t mark);
     bool putItem(Item& item, const std::tuple<long, long, long>& position);
     float scoreRotation(const Item& item, const std::tuple<long, long, long>& position, RotationType rotation_type) const;
     RotationType getBestRotationOrder(const Item& item, const std::tuple<long, long, long>& position) const;
@@ -34,6 +52,127 @@ public:
     
     // Make sure this declaration is properly visible
     bool canItemFit(const Item& item, const std::tuple<long, long, long>& position) const;
+
+    // Rotations (bit per RotationType) among the item's allowed ones in which
+    // it fits inside this bin when empty. Nothing is placed or changed.
+    uint8_t probe(const Item& item) const;
+
+    // Distinct orientations of the item in this bin with their scores, built
+    // once per item size and allowed rotations
+    const OrientationTable& getOrientations(const Item& item) const;
+
+    // Visit the placed items whose boxes may touch the region, nearest cells only.
+    // The visitor gets the item and returns true to stop the walk early.
+    template <typename Visitor>
+    bool forEachItemNear(const GridBox& region, Visitor&& visit) const;
+
+    // Same walk, handing out indices into getPlacedBoxes() (and `items`)
+    template <typename Visitor>
+    bool forEachPlacedNear(const GridBox& region, Visitor&& visit) const;
+
+    // Packed copy of the placed boxes, index-aligned with `items`
+    const PlacedBoxes& getPlacedBoxes() const;
+
+    // Running totals of the placed load, kept in step with `items`
+    float getTotalWeight() const;
+    long getUsedVolume() const;
+    double getFillRatio() const;                  // used volume over bin volume
+    GridBox getLoadBounds() const;                // box around every placed item
+    std::array<long, 3> getMaxOccupied() const;   // highest coordinate used on each axis
+    // Weighted by item weight, or by volume while the load weighs nothing
+    std::array<double, 3> getCenterOfMass() const;
+
+    // Which placed boxes lie on which, index-aligned with `items`
+    const SupportGraph& getSupportGraph() const;
+
+    // True if the pose, or the item at its current position and rotation,
+    // overlaps a placed item
+    bool intersectsPlacedItem(const ItemGeometry& geometry) const;
+    bool intersectsPlacedItem(const Item& item) const;
+
+    // Visit candidate positions for the next item, nearest to the origin first.
+    // The visitor gets a position and returns true to stop; it may put the item
+    // and remove it again, but must not ask for candidates itself.
+    // Positions blocked for every item with no edge shorter than
+    // `shortest_edge` are skipped.
+    template <typename Visitor>
+    bool forEachCandidatePosition(Visitor&& visit, long shortest_edge = 0) const;
+
+    // Stop offering this candidate position, e.g. once nothing still to come
+    // fits there. Rolling back does not bring it back.
+    void retireCandidate(const std::tuple<long, long, long>& position);
+    // Skip this candidate position for items with no edge shorter than `edge`
+    void blockCandidate(const std::tuple<long, long, long>& position, long edge);
+
+    // Largest free cuboids left between the placed items
+    const MaximalSpaceSet& getFreeSpaces() const;
+
+    // Top of the load over the floor, in square cells of the given size
+    const HeightMap& getHeightMap(long cell) const;
+
+private:
+    std::vector<std::reference_wrapper<Item>> items;
+
+    void indexItem(std::size_t index);
+    void rebuildIndex() const;
+    void syncIndex() const;
+    void syncCandidates() const;
+    void syncSpaces() const;
+    void syncHeights(long cell) const;
+    void syncSupport() const;
+    void popItem();
+
+    // Spatial index over `items`, keyed by position in the vector. It keeps
+    // the boxes as they were indexed, so removal does not depend on later moves.
+    mutable SpatialGrid grid;
+    mutable PlacedBoxes placed;
+
+    // Extreme points of the first `candidates_synced` items. Items are folded
+    // in lazily when candidates are asked for, so a put that is undone right
+    // away never touches the set.
+    mutable ExtremePointSet candidate_points;
+    mutable std::size_t candidates_synced = 0;
+
+    // Free spaces around the first `spaces_synced` items, folded in lazily
+    // the same way, and only once asked for
+    mutable MaximalSpaceSet free_spaces;
+    mutable std::size_t spaces_synced = 0;
+
+    // Height map of the first `heights_synced` items, likewise; started
+    // over when asked for with another cell size
+    mutable HeightMap height_map;
+    mutable std::size_t heights_synced = 0;
+
+    // Support links of the first `support_synced` items, folded in lazily
+    // the same way
+    mutable SupportGraph support;
+    mutable std::size_t support_synced = 0;
+
+    mutable OrientationCache orientation_cache;
 };
 
+template <typename Visitor>
+bool Bin::forEachItemNear(const GridBox& region, Visitor&& visit) const {
+    syncIndex();
+    return grid.forEachInRegion(region, [this, &visit](uint32_t index) {
+        return visit(items[index].get());
+    });
+}
+
+template <typename Visitor>
+bool Bin::forEachPlacedNear(const GridBox& region, Visitor&& visit) const {
+    syncIndex();
+    return grid.forEachInRegion(region, [&visit](uint32_t index) {
+        return visit(static_cast<std::size_t>(index));
+    });
+}
+
+template <typename Visitor>
+bool Bin::forEachCandidatePosition(Visitor&& visit, long shortest_edge) const {
+    syncCandidates();
+    return candidate_points.forEachInOrder([&visit](const ExtremePointSet::Point& p) {
+        return visit(std::tuple<long, long, long>{p[0], p[1], p[2]});
+    }, shortest_edge);
+}
+
 #endif // BIN_H
@@ -0,0 +1,26 @@
+#include "bin_index.h"
+
+std::array<long, 3> sortedDimensions(const Box& box) {
+    std::array<long, 3> dims = {box.getWidth(), box.getHeight(), box.getDepth()};
+    std::sort(dims.begin(), dims.end());
+    return dims;
+}
+
+BinIndex::BinIndex() : indexed_data(nullptr), indexed_size(0) {}
+
+void BinIndex::build(const std::vector<Bin>& bins) {
+    entries.clear();
+    entries.reserve(bins.size());
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+        entries.push_back({bins[i].getVolume(), sortedDimensions(bins[i]), i});
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.volume < b.volume;
+    });
+    indexed_data = bins.data();
+    indexed_size = bins.size();
+}
+
+bool BinIndex::matches(const std::vector<Bin>& bins) const {
+    return indexed_data == bins.data() && indexed_size == bins.size();
+}
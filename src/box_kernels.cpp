@@ -0,0 +1,148 @@
+#include "box_kernels.h"
+
+#if defined(__x86_64__) && defined(__LP64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOX_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Scalar kernels, also used for the tail of every vector loop
+
+static std::size_t firstOverlapScalar(const PlacedBoxes& boxes, std::size_t begin, std::size_t end, const GridBox& box) {
+    for (std::size_t i = begin; i < end; ++i) {
+        if (boxes.overlaps(i, box)) {
+            return i;
+        }
+    }
+    return end;
+}
+
+static void boundsFitMasksScalar(const std::array<long, 3>* positions, std::size_t count,
+                                 const std::array<long, 3>* dimensions, std::size_t dimension_count,
+                                 const std::array<long, 3>& extent, uint8_t* masks) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& p = positions[i];
+        uint8_t mask = 0;
+        for (std::size_t k = 0; k < dimension_count; ++k) {
+            const auto& d = dimensions[k];
+            if (p[0] + d[0] <= extent[0] && p[1] + d[1] <= extent[1] && p[2] + d[2] <= extent[2]) {
+                mask |= uint8_t(1u << k);
+            }
+        }
+        masks[i] = mask;
+    }
+}
+
+#ifdef BOX_KERNELS_AVX2
+
+static_assert(sizeof(std::array<long, 3>) == 3 * sizeof(long long), "positions are gathered as packed triples");
+
+// Four boxes at a time: lane j is all ones when box `index + j` overlaps
+__attribute__((target("avx2")))
+static inline int overlapLanes(const PlacedBoxes& boxes, std::size_t index,
+                               const __m256i box_min[3], const __m256i box_max[3]) {
+    const std::vector<long>* mins[3] = {&boxes.min_x, &boxes.min_y, &boxes.min_z};
+    const std::vector<long>* maxs[3] = {&boxes.max_x, &boxes.max_y, &boxes.max_z};
+    __m256i hit = _mm256_set1_epi64x(-1);
+    for (int axis = 0; axis < 3; ++axis) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mins[axis]->data() + index));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(maxs[axis]->data() + index));
+        // lo < box.max && box.min < hi
+        hit = _mm256_and_si256(hit, _mm256_cmpgt_epi64(box_max[axis], lo));
+        hit = _mm256_and_si256(hit, _mm256_cmpgt_epi64(hi, box_min[axis]));
+    }
+    return _mm256_movemask_pd(_mm256_castsi256_pd(hit));
+}
+
+__attribute__((target("avx2")))
+static void broadcastBox(const GridBox& box, __m256i box_min[3], __m256i box_max[3]) {
+    for (int axis = 0; axis < 3; ++axis) {
+        box_min[axis] = _mm256_set1_epi64x(box.min[axis]);
+        box_max[axis] = _mm256_set1_epi64x(box.max[axis]);
+    }
+}
+
+__attribute__((target("avx2")))
+static std::size_t firstOverlapAvx2(const PlacedBoxes& boxes, std::size_t begin, std::size_t end, const GridBox& box) {
+    __m256i box_min[3], box_max[3];
+    broadcastBox(box, box_min, box_max);
+
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        int lanes = overlapLanes(boxes, i, box_min, box_max);
+        if (lanes != 0) {
+            return i + __builtin_ctz(static_cast<unsigned>(lanes));
+        }
+    }
+    return firstOverlapScalar(boxes, i, end, box);
+}
+
+__attribute__((target("avx2")))
+static void boundsFitMasksAvx2(const std::array<long, 3>* positions, std::size_t count,
+                               const std::array<long, 3>* dimensions, std::size_t dimension_count,
+                               const std::array<long, 3>& extent, uint8_t* masks) {
+    // Positions are stored x, y, z back to back; gather one axis of four of them
+    const __m256i stride = _mm256_setr_epi64x(0, 3, 6, 9);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const long long* base = reinterpret_cast<const long long*>(positions[i].data());
+        __m256i axis_values[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            axis_values[axis] = _mm256_i64gather_epi64(base + axis, stride, 8);
+        }
+
+        uint32_t lane_masks[4] = {0, 0, 0, 0};
+        for (std::size_t k = 0; k < dimension_count; ++k) {
+            // A size fits when no axis goes past extent - size
+            __m256i outside = _mm256_setzero_si256();
+            for (int axis = 0; axis < 3; ++axis) {
+                __m256i limit = _mm256_set1_epi64x(extent[axis] - dimensions[k][axis]);
+                outside = _mm256_or_si256(outside, _mm256_cmpgt_epi64(axis_values[axis], limit));
+            }
+            int fits = ~_mm256_movemask_pd(_mm256_castsi256_pd(outside)) & 0xF;
+            for (int lane = 0; lane < 4; ++lane) {
+                lane_masks[lane] |= ((fits >> lane) & 1u) << k;
+            }
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            masks[i + lane] = static_cast<uint8_t>(lane_masks[lane]);
+        }
+    }
+    boundsFitMasksScalar(positions + i, count - i, dimensions, dimension_count, extent, masks + i);
+}
+
+static bool cpuHasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#endif // BOX_KERNELS_AVX2
+
+bool boxKernelsUseAvx2() {
+#ifdef BOX_KERNELS_AVX2
+    return cpuHasAvx2();
+#else
+    return false;
+#endif
+}
+
+std::size_t firstOverlap(const PlacedBoxes& boxes, std::size_t begin, std::size_t end, const GridBox& box) {
+#ifdef BOX_KERNELS_AVX2
+    if (cpuHasAvx2()) {
+        return firstOverlapAvx2(boxes, begin, end, box);
+    }
+#endif
+    return firstOverlapScalar(boxes, begin, end, box);
+}
+
+void boundsFitMasks(const std::array<long, 3>* positions, std::size_t count,
+                    const std::array<long, 3>* dimensions, std::size_t dimension_count,
+                    const std::array<long, 3>& extent, uint8_t* masks) {
+#ifdef BOX_KERNELS_AVX2
+    if (cpuHasAvx2()) {
+        boundsFitMasksAvx2(positions, count, dimensions, dimension_count, extent, masks);
+        return;
+    }
+#endif
+    boundsFitMasksScalar(positions, count, dimensions, dimension_count, extent, masks);
+}
@@ -0,0 +1,250 @@
+#include "brkga.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include "work_pool.h"
+
+namespace {
+
+using Keys = std::vector<double>;
+
+struct Fitness {
+    double packed_volume = 0;
+    std::size_t bins_used = 0;
+};
+
+struct Member {
+    Keys keys;
+    Fitness fitness;
+};
+
+// Whether fitness a beats fitness b under the objective
+bool better(const Fitness& a, const Fitness& b, PortfolioObjective objective) {
+    return packsBetter(a.packed_volume, static_cast<long>(a.bins_used), b.packed_volume,
+                       static_cast<long>(b.bins_used), objective);
+}
+
+// Packs chromosomes on its own copy of the items and bins
+class Decoder {
+public:
+    explicit Decoder(const Packer& base) : packer(base) {
+        for (const Item& item : packer.items) {
+            allowed.push_back(item.getAllowedRotations());
+        }
+    }
+
+    Fitness decode(const Keys& keys) {
+        pose(keys);
+        return {packedVolume(packer), binsUsed(packer)};
+    }
+
+    // Pack the chromosome, then give every item back its own allowed rotations
+    void pose(const Keys& keys) {
+        const std::size_t count = packer.items.size();
+        ranking.resize(count);
+        std::iota(ranking.begin(), ranking.end(), 0);
+        std::stable_sort(ranking.begin(), ranking.end(), [&keys](std::size_t a, std::size_t b) {
+            return keys[a] < keys[b];
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            const double key = keys[count + i];
+            auto& rotations = packer.items[i]._allowed_rotations;
+            rotations = allowed[i];
+            if (key >= 0.5) {
+                const std::size_t pick = std::min(rotations.size() - 1,
+                                                  static_cast<std::size_t>((key - 0.5) * 2 * rotations.size()));
+                rotations = {allowed[i][pick]};
+            }
+        }
+        packer.packRanked(ranking);
+        for (std::size_t i = 0; i < count; ++i) {
+            packer.items[i]._allowed_rotations = allowed[i];
+        }
+    }
+
+    Packer packer;
+
+private:
+    std::vector<std::vector<RotationType>> allowed;  // per item, as the caller gave them
+    std::vector<std::size_t> ranking;
+};
+
+Keys randomKeys(std::size_t length, std::mt19937& rng) {
+    std::uniform_real_distribution<double> key(0.0, 1.0);
+    Keys keys(length);
+    for (double& k : keys) {
+        k = key(rng);
+    }
+    return keys;
+}
+
+// Keys that reproduce pack()'s default order with the bin's own rotations
+Keys greedyKeys(const Packer& packer) {
+    const std::size_t count = packer.items.size();
+    std::vector<std::size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&packer](std::size_t a, std::size_t b) {
+        return packer.items[a].getVolume() > packer.items[b].getVolume();
+    });
+    Keys keys(2 * count, 0.0);
+    for (std::size_t rank = 0; rank < count; ++rank) {
+        keys[order[rank]] = static_cast<double>(rank) / static_cast<double>(count);
+    }
+    return keys;
+}
+
+}  // namespace
+
+BrkgaResult packBrkga(Packer& packer, const BrkgaOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const PackOptions caller_options = packer.getOptions();
+    auto stop_time = start + options.budget;
+    if (caller_options.deadline) {
+        stop_time = std::min(stop_time, *caller_options.deadline);
+    }
+    auto shouldStop = [&]() {
+        return (caller_options.cancel && caller_options.cancel->isCancelled()) ||
+               std::chrono::steady_clock::now() >= stop_time;
+    };
+
+    // Decodes share the packer's cancel token and stop at the search's
+    // deadline; progress is not reported from the workers
+    PackOptions decode_options = caller_options;
+    decode_options.deadline = stop_time;
+    decode_options.progress = nullptr;
+    Packer base(packer);
+    base.setOptions(decode_options);
+    base.packRanked({});  // turns SKUs into items, so the chromosome length is known
+    const std::size_t length = 2 * base.items.size();
+
+    const std::size_t population = std::max<std::size_t>(2, options.population);
+    const std::size_t elites = std::clamp<std::size_t>(
+        static_cast<std::size_t>(std::lround(options.elite_fraction * population)), 1, population - 1);
+    const std::size_t mutants = std::min(population - elites,
+        static_cast<std::size_t>(std::lround(options.mutant_fraction * population)));
+
+    const std::size_t worker_count = std::min(population, std::max<std::size_t>(1, options.threads));
+    std::vector<std::unique_ptr<Decoder>> decoders;
+    for (std::size_t w = 0; w < worker_count; ++w) {
+        decoders.push_back(std::make_unique<Decoder>(base));
+    }
+
+    BrkgaResult result;
+    std::mt19937 rng(options.seed);
+    std::vector<Member> members(population);
+    for (std::size_t m = 0; m < population; ++m) {
+        members[m].keys = m == 0 && options.seed_with_greedy ? greedyKeys(base) : randomKeys(length, rng);
+    }
+
+    // The packed solution of members[0], copied from the decoder that packed
+    // it. Within a generation a decode takes its place if it is better, or as
+    // good and earlier in `members`, so it always ends up with the member the
+    // stable sort puts first.
+    std::mutex best_mutex;
+    std::optional<Packer> best_packer;
+    std::size_t best_slot = 0;
+
+    {
+        WorkPool pool(worker_count);
+        // Decode members [from, population) in parallel
+        auto decodeFrom = [&](std::size_t from) {
+            std::vector<std::future<void>> done;
+            for (std::size_t m = from; m < population; ++m) {
+                auto finished = std::make_shared<std::promise<void>>();
+                done.push_back(finished->get_future());
+                pool.submit([&, m, finished](std::size_t worker) {
+                    try {
+                        const Fitness fitness = decoders[worker]->decode(members[m].keys);
+                        members[m].fitness = fitness;
+                        std::lock_guard<std::mutex> lock(best_mutex);
+                        if (!best_packer || better(fitness, members[best_slot].fitness, options.objective) ||
+                            (m < best_slot && !better(members[best_slot].fitness, fitness, options.objective))) {
+                            best_packer = decoders[worker]->packer;
+                            best_slot = m;
+                        }
+                        finished->set_value();
+                    } catch (...) {
+                        finished->set_exception(std::current_exception());
+                    }
+                });
+            }
+            for (auto& future : done) {
+                future.get();
+            }
+            best_slot = 0;
+            result.decoded += population - from;
+
+            // Best first; equal members keep their places
+            std::stable_sort(members.begin(), members.end(), [&options](const Member& a, const Member& b) {
+                return better(a.fitness, b.fitness, options.objective);
+            });
+            double total = 0;
+            for (const Member& member : members) {
+                total += member.fitness.packed_volume;
+            }
+            result.log.push_back({result.log.size(), members[0].fitness.packed_volume, members[0].fitness.bins_used,
+                                  total / static_cast<double>(population),
+                                  std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::steady_clock::now() - start)});
+            if (options.on_generation) {
+                options.on_generation(result.log.back());
+            }
+        };
+
+        decodeFrom(0);
+        std::size_t stall = 0;
+        std::uniform_int_distribution<std::size_t> elite_parent(0, elites - 1);
+        std::uniform_int_distribution<std::size_t> other_parent(elites, population - 1);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        while (result.generations < options.generations && !shouldStop() &&
+               (options.max_stall_generations == 0 || stall < options.max_stall_generations)) {
+            // Elites stay as they are; children fill the middle, mutants the end
+            const Fitness best = members[0].fitness;
+            std::vector<Member> next(members.begin(), members.begin() + elites);
+            while (next.size() < population - mutants) {
+                const Keys& elite = members[elite_parent(rng)].keys;
+                const Keys& other = members[other_parent(rng)].keys;
+                Keys child(length);
+                for (std::size_t k = 0; k < length; ++k) {
+                    child[k] = coin(rng) < options.elite_bias ? elite[k] : other[k];
+                }
+                next.push_back({std::move(child), {}});
+            }
+            while (next.size() < population) {
+                next.push_back({randomKeys(length, rng), {}});
+            }
+            members = std::move(next);
+            decodeFrom(elites);
+            ++result.generations;
+            stall = better(members[0].fitness, best, options.objective) ? 0 : stall + 1;
+        }
+    }
+
+    // Leave the best solution in the caller's packer, with the options it had
+    packer = std::move(*best_packer);
+    packer.setOptions(caller_options);
+    result.packed_volume = members[0].fitness.packed_volume;
+    result.bins_used = members[0].fitness.bins_used;
+    result.best_keys = members[0].keys;
+
+    // unfit_items hold copies made while the rotations were pinned
+    std::vector<bool> placed(packer.items.size(), false);
+    for (const auto& bin : packer.bins) {
+        for (const auto& ref : bin.getItems()) {
+            placed[static_cast<std::size_t>(&ref.get() - packer.items.data())] = true;
+        }
+    }
+    packer.unfit_items.clear();
+    for (std::size_t i = 0; i < packer.items.size(); ++i) {
+        if (!placed[i]) {
+            packer.unfit_items.push_back(packer.items[i]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,215 @@
+#include "extreme_points.h"
+#include <algorithm>
+#include <limits>
+
+// Rebuild the heap once it holds more dead entries than this many above the live ones
+const std::size_t STALE_HEAP_SLACK = 32;
+
+// blocked_edge of a point no cube has been found blocked at
+const long UNBLOCKED = std::numeric_limits<long>::max();
+
+static bool contains(const GridBox& box, const ExtremePointSet::Point& p) {
+    return box.min[0] <= p[0] && p[0] < box.max[0] &&
+           box.min[1] <= p[1] && p[1] < box.max[1] &&
+           box.min[2] <= p[2] && p[2] < box.max[2];
+}
+
+std::size_t ExtremePointSet::PointHash::operator()(const Point& p) const {
+    std::size_t h = std::hash<long>()(p[0]);
+    h = h * 1000003u ^ std::hash<long>()(p[1]);
+    h = h * 1000003u ^ std::hash<long>()(p[2]);
+    return h;
+}
+
+ExtremePointSet::ExtremePointSet() : stale_in_heap(0) {
+    clear();
+}
+
+void ExtremePointSet::clear() {
+    entries.clear();
+    lookup.clear();
+    live.clear();
+    heap.clear();
+    journal.clear();
+    changes.clear();
+    stale_in_heap = 0;
+    revive({0, 0, 0});
+    changes.clear();
+}
+
+std::size_t ExtremePointSet::depth() const {
+    return journal.size();
+}
+
+std::size_t ExtremePointSet::size() const {
+    return live.size();
+}
+
+bool ExtremePointSet::before(uint32_t a, uint32_t b) const {
+    const Entry& ea = entries[a];
+    const Entry& eb = entries[b];
+    if (ea.distance != eb.distance) {
+        return ea.distance < eb.distance;
+    }
+    // Prefer low positions, then the back of the bin, then the left wall
+    if (ea.point[1] != eb.point[1]) {
+        return ea.point[1] < eb.point[1];
+    }
+    if (ea.point[2] != eb.point[2]) {
+        return ea.point[2] < eb.point[2];
+    }
+    return ea.point[0] < eb.point[0];
+}
+
+void ExtremePointSet::heapPush(uint32_t index) {
+    entries[index].in_heap = true;
+    std::size_t slot = heap.size();
+    heap.push_back(index);
+    while (slot > 0) {
+        std::size_t parent = (slot - 1) / 2;
+        if (!before(heap[slot], heap[parent])) {
+            break;
+        }
+        std::swap(heap[slot], heap[parent]);
+        slot = parent;
+    }
+}
+
+void ExtremePointSet::compact() {
+    for (uint32_t index : heap) {
+        entries[index].in_heap = false;
+    }
+    heap.clear();
+    for (uint32_t index : live) {
+        heapPush(index);
+    }
+    stale_in_heap = 0;
+}
+
+bool ExtremePointSet::revive(const Point& point) {
+    auto it = lookup.find(point);
+    if (it == lookup.end()) {
+        uint32_t index = static_cast<uint32_t>(entries.size());
+        entries.push_back({point, point[0] + point[1] + point[2], UNBLOCKED, 0, false, false});
+        lookup.emplace(point, index);
+        makeLive(index);
+        heapPush(index);
+        changes.push_back(index);
+        return true;
+    }
+
+    Entry& entry = entries[it->second];
+    if (entry.alive) {
+        return false;
+    }
+    entry.blocked_edge = UNBLOCKED;
+    makeLive(it->second);
+    if (entry.in_heap) {
+        --stale_in_heap;
+    } else {
+        heapPush(it->second);
+    }
+    changes.push_back(it->second);
+    return true;
+}
+
+void ExtremePointSet::makeLive(uint32_t index) {
+    entries[index].alive = true;
+    entries[index].live_slot = static_cast<uint32_t>(live.size());
+    live.push_back(index);
+}
+
+void ExtremePointSet::kill(uint32_t index) {
+    // Move the last live id into the freed slot
+    const uint32_t slot = entries[index].live_slot;
+    live[slot] = live.back();
+    entries[live[slot]].live_slot = slot;
+    live.pop_back();
+    entries[index].alive = false;
+    ++stale_in_heap;
+}
+
+void ExtremePointSet::push(const GridBox& box, uint32_t id, const SpatialGrid& grid, const Point& extent) {
+    JournalEntry record{static_cast<uint32_t>(changes.size()), 0, 0};
+
+    // Points inside the new box can no longer anchor anything. Walking the
+    // live ids backwards, a kill only moves an id already looked at.
+    for (std::size_t slot = live.size(); slot-- > 0;) {
+        const uint32_t index = live[slot];
+        if (contains(box, entries[index].point)) {
+            kill(index);
+            changes.push_back(index);
+            ++record.killed;
+        }
+    }
+
+    const Point anchors[3] = {
+        {box.max[0], box.min[1], box.min[2]},
+        {box.min[0], box.max[1], box.min[2]},
+        {box.min[0], box.min[1], box.max[2]}
+    };
+    for (const Point& anchor : anchors) {
+        if (anchor[0] >= extent[0] || anchor[1] >= extent[1] || anchor[2] >= extent[2]) {
+            continue;
+        }
+
+        // Only boxes landed so far may cover the anchor, later ids are tentative
+        GridBox probe{anchor, {anchor[0] + 1, anchor[1] + 1, anchor[2] + 1}};
+        bool covered = grid.forEachInRegion(probe, [&](uint32_t other) {
+            return other <= id && contains(grid.boxOf(other), anchor);
+        });
+        if (!covered && revive(anchor)) {
+            ++record.added;
+        }
+    }
+
+    journal.push_back(record);
+
+    if (stale_in_heap > live.size() + STALE_HEAP_SLACK) {
+        compact();
+    }
+}
+
+void ExtremePointSet::retire(const Point& point) {
+    auto it = lookup.find(point);
+    if (it != lookup.end() && entries[it->second].alive) {
+        kill(it->second);
+        if (stale_in_heap > live.size() + STALE_HEAP_SLACK) {
+            compact();
+        }
+    }
+}
+
+void ExtremePointSet::block(const Point& point, long edge) {
+    auto it = lookup.find(point);
+    if (it != lookup.end()) {
+        Entry& entry = entries[it->second];
+        entry.blocked_edge = std::min(entry.blocked_edge, edge);
+    }
+}
+
+void ExtremePointSet::pop() {
+    if (journal.empty()) {
+        return;
+    }
+    JournalEntry record = journal.back();
+    journal.pop_back();
+
+    // Points added by the push may have been retired since
+    uint32_t first_added = record.first_change + record.killed;
+    for (uint32_t i = first_added; i < first_added + record.added; ++i) {
+        if (entries[changes[i]].alive) {
+            kill(changes[i]);
+        }
+    }
+    for (uint32_t i = record.first_change; i < first_added; ++i) {
+        Entry& entry = entries[changes[i]];
+        makeLive(changes[i]);
+        if (entry.in_heap) {
+            --stale_in_heap;
+        } else {
+            heapPush(changes[i]);
+        }
+    }
+    changes.resize(record.first_change);
+}
@@ -0,0 +1,87 @@
+#include "height_map.h"
+#include <algorithm>
+
+HeightMap::HeightMap() : floor_width(0), floor_depth(0), cell(0), columns(0), rows(0) {}
+
+void HeightMap::reset(long width, long depth, long cell_size) {
+    floor_width = width;
+    floor_depth = depth;
+    cell = std::max(1L, cell_size);
+    columns = std::max(1L, (width + cell - 1) / cell);
+    rows = std::max(1L, (depth + cell - 1) / cell);
+    tops.assign(static_cast<std::size_t>(columns * rows), 0);
+    undo.clear();
+    journal.clear();
+}
+
+bool HeightMap::covers(long width, long depth, long cell_size) const {
+    return floor_width == width && floor_depth == depth && cell == std::max(1L, cell_size) && !tops.empty();
+}
+
+std::pair<long, long> HeightMap::cellRange(long from, long length, long count) const {
+    long first = std::clamp(from / cell, 0L, count - 1);
+    long last = std::clamp((from + length - 1) / cell, first, count - 1);
+    return {first, last};
+}
+
+void HeightMap::push(const GridBox& box) {
+    journal.push_back(static_cast<uint32_t>(undo.size()));
+    const auto [first_column, last_column] = cellRange(box.min[0], box.max[0] - box.min[0], columns);
+    const auto [first_row, last_row] = cellRange(box.min[2], box.max[2] - box.min[2], rows);
+    for (long row = first_row; row <= last_row; ++row) {
+        for (long column = first_column; column <= last_column; ++column) {
+            const uint32_t index = static_cast<uint32_t>(row * columns + column);
+            if (tops[index] < box.max[1]) {
+                undo.push_back({index, tops[index]});
+                tops[index] = box.max[1];
+            }
+        }
+    }
+}
+
+void HeightMap::pop() {
+    if (journal.empty()) {
+        return;
+    }
+    const std::size_t mark = journal.back();
+    journal.pop_back();
+    while (undo.size() > mark) {
+        tops[undo.back().first] = undo.back().second;
+        undo.pop_back();
+    }
+}
+
+std::size_t HeightMap::depth() const {
+    return journal.size();
+}
+
+long HeightMap::restingHeight(long x, long z, long w, long d) const {
+    const auto [first_column, last_column] = cellRange(x, w, columns);
+    const auto [first_row, last_row] = cellRange(z, d, rows);
+    long height = 0;
+    for (long row = first_row; row <= last_row; ++row) {
+        const long* line = tops.data() + row * columns;
+        height = std::max(height, *std::max_element(line + first_column, line + last_column + 1));
+    }
+    return height;
+}
+
+double HeightMap::supportedFraction(long x, long y, long z, long w, long d) const {
+    if (w <= 0 || d <= 0) {
+        return 0.0;
+    }
+    const auto [first_column, last_column] = cellRange(x, w, columns);
+    const auto [first_row, last_row] = cellRange(z, d, rows);
+    long supported = 0;
+    for (long row = first_row; row <= last_row; ++row) {
+        // Part of the base over this row of cells
+        const long row_span = std::min(z + d, (row + 1) * cell) - std::max(z, row * cell);
+        for (long column = first_column; column <= last_column; ++column) {
+            if (tops[row * columns + column] == y) {
+                const long column_span = std::min(x + w, (column + 1) * cell) - std::max(x, column * cell);
+                supported += row_span * column_span;
+            }
+        }
+    }
+    return static_cast<double>(supported) / (static_cast<double>(w) * d);
+}
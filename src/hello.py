@@ -8,16 +8,14 @@ import time
 
 packer = pybinding.Packer()
 packer.add_bin(pybinding.Bin('Le grande box', 2500, 2650, 13600))
-for i in range(80):
-    packer.add_item(pybinding.Item(f'Bag {i}', 500, 400, 300))
-for i in range(100):
-    packer.add_item(pybinding.Item(f'Sack {i}', 1000, 450, 300))
-for i in range(150):
-    packer.add_item(pybinding.Item(f'Box {i}', 1000, 1000, 1000))
+packer.add_item_type(pybinding.Item('Bag', 500, 400, 300), 80)
+packer.add_item_type(pybinding.Item('Sack', 1000, 450, 300), 100)
+packer.add_item_type(pybinding.Item('Box', 1000, 1000, 1000), 150)
 
 start = time.time()
 packer.pack()
 print("Time taken:", time.time() - start)
+print("packed per SKU:", packer.get_packed_quantities())
 
 print("packed bins:", packer.get_bins())
 print("unfit items:", packer.get_unfit_items(), len(packer.get_unfit_items()))
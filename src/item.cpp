@@ -51,29 +51,38 @@ std::string Item::getRotationTypeString() const {
     return ROTATION_TYPE_STRINGS.at(_rotation_type);
 }
 
-std::vector<long> Item::getDimension() const {
-    switch (_rotation_type) {
-        case RotationType::whd:
-            return {width, height, depth};
-        case RotationType::hwd:
-            return {height, width, depth};
-        case RotationType::hdw:
-            return {height, depth, width};
-        case RotationType::dhw:
-            return {depth, height, width};
-        case RotationType::dwh:
-            return {depth, width, height};
-        case RotationType::wdh:
-            return {width, depth, height};
-        default:
-            return {width, height, depth};
+bool ItemGeometry::intersects(const ItemGeometry& other) const {
+    for (size_t axis = 0; axis < 3; ++axis) {
+        if (position[axis] >= other.position[axis] + other.dimension[axis] ||
+            other.position[axis] >= position[axis] + dimension[axis]) {
+            return false;
+        }
     }
+    return true;
+}
+
+std::vector<long> Item::getDimension() const {
+    auto d = rotateDimension(width, height, depth, _rotation_type);
+    return {d.begin(), d.end()};
+}
+
+ItemGeometry Item::getGeometry() const {
+    return getGeometry(_rotation_type, _position);
+}
+
+ItemGeometry Item::getGeometry(RotationType rotation, const std::tuple<long, long, long>& position) const {
+    return ItemGeometry{
+        rotateDimension(width, height, depth, rotation),
+        {std::get<0>(position), std::get<1>(position), std::get<2>(position)},
+        rotation,
+        weight
+    };
 }
 
 template <size_t X, size_t Y>
 bool rectIntersectImpl(const Item& item1, const Item& item2) {
-    const auto& d1 = item1.getDimension();
-    const auto& d2 = item2.getDimension();
+    const auto d1 = item1.getGeometry().dimension;
+    const auto d2 = item2.getGeometry().dimension;
     const auto& p1 = item1.getPosition();
     const auto& p2 = item2.getPosition();
 
@@ -104,11 +113,9 @@ bool rectIntersect(const Item& item1, const Item& item2, Axis x, Axis y) {
 }
 
 bool Item::doesIntersect(const Item& other) const {
-    // Check intersection in all three planes
-    bool xy = rectIntersect(*this, other, Axis::width, Axis::height);
-    bool yz = rectIntersect(*this, other, Axis::height, Axis::depth);
-    bool xz = rectIntersect(*this, other, Axis::width, Axis::depth);
-    return xy && yz && xz;
+    // Overlapping in all three planes is overlapping on every axis, which the
+    // integer test answers without building the three projections
+    return getGeometry().intersects(other.getGeometry());
 }
 
 bool Item::operator==(const Item& other) const {
@@ -117,7 +124,7 @@ bool Item::operator==(const Item& other) const {
 
 std::ostream& operator<<(std::ostream& os, const Item& item) {
     os << "Item: " << item.name << " (" << item.getRotationTypeString() << " = ";
-    const auto& dim = item.getDimension();
+    const auto dim = item.getGeometry().dimension;
     os << dim[0] << " x " << dim[1] << " x " << dim[2] << ")";
     return os;
 }
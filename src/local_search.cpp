@@ -0,0 +1,487 @@
+#include "local_search.h"
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <random>
+#include "work_pool.h"
+
+namespace {
+
+constexpr long UNFIT = -1;
+// Unfit items offered, smallest first, to a bin a move took room from
+constexpr std::size_t TOP_UP_ATTEMPTS = 16;
+
+struct Move {
+    MoveKind kind;
+    std::size_t bin;
+    std::size_t item;   // placed item taken out; unused by INSERT and EMPTY_BIN
+    std::size_t unfit;  // unfit item put in; unused by EMPTY_BIN
+};
+
+// What a move changed: objective deltas and every bin it wrote to
+struct Outcome {
+    bool feasible = false;
+    double volume = 0;  // change in packed volume
+    long bins = 0;      // change in bins used
+    std::vector<std::size_t> touched;
+    std::vector<std::size_t> filled;  // unfit items it placed
+};
+
+bool improves(const Outcome& outcome, PortfolioObjective objective) {
+    return outcome.feasible && packsBetter(outcome.volume, outcome.bins, 0, 0, objective);
+}
+
+// Whether outcome a is better than outcome b under the objective
+bool better(const Outcome& a, const Outcome& b, PortfolioObjective objective) {
+    return packsBetter(a.volume, a.bins, b.volume, b.bins, objective);
+}
+
+// A packer and which bin holds each of its items. Moves are applied through
+// a journal, so the latest one can be undone touching only the bins it wrote to.
+class Neighbourhood {
+public:
+    explicit Neighbourhood(const Packer& source) : packer(source) {
+        index();
+    }
+
+    void sync(const Packer& source) {
+        packer = source;
+        index();
+    }
+
+    Outcome apply(const Move& move);
+    void undo();
+
+    Packer packer;
+    std::vector<long> bin_of;  // per item, UNFIT if no bin holds it
+
+private:
+    struct Pose {
+        std::size_t item;
+        std::tuple<long, long, long> position;
+        RotationType rotation;
+        long bin;
+    };
+
+    // Bins are restored before poses for a PUT and after them otherwise, so
+    // any index a bin rebuilds sees its items where they were at that step
+    struct Step {
+        enum { PUT, TAKE, CLEAR, POSE } kind;
+        std::size_t bin;
+        std::size_t item;
+        std::vector<std::reference_wrapper<Item>> before;  // bin contents before a TAKE or CLEAR
+        std::vector<Pose> poses;                            // items as they were before the step
+    };
+
+    void index();
+    double volumeOf(std::size_t item) const;
+    void touch(Outcome& outcome, std::size_t bin) const;
+    Pose poseOf(std::size_t item) const;
+    bool movable(std::size_t bin, std::size_t item) const;
+    void take(Outcome& outcome, std::size_t bin, std::size_t item);
+    bool put(Outcome& outcome, std::size_t bin, std::size_t item, bool best_fit = false,
+             const std::optional<std::tuple<long, long, long>>& corner = std::nullopt);
+    bool putElsewhere(Outcome& outcome, std::size_t except, std::size_t item);
+    void topUp(Outcome& outcome, std::size_t bin, std::size_t taken);
+
+    std::vector<Step> steps;
+};
+
+void Neighbourhood::index() {
+    bin_of.assign(packer.items.size(), UNFIT);
+    const Item* first = packer.items.data();
+    for (std::size_t b = 0; b < packer.bins.size(); ++b) {
+        for (const auto& ref : packer.bins[b].getItems()) {
+            // Online arrivals live outside `items` and are left where they are
+            const Item* item = &ref.get();
+            if (item >= first && item < first + packer.items.size()) {
+                bin_of[static_cast<std::size_t>(item - first)] = static_cast<long>(b);
+            }
+        }
+    }
+}
+
+double Neighbourhood::volumeOf(std::size_t item) const {
+    return static_cast<double>(packer.items[item].getVolume());
+}
+
+void Neighbourhood::touch(Outcome& outcome, std::size_t bin) const {
+    if (std::find(outcome.touched.begin(), outcome.touched.end(), bin) == outcome.touched.end()) {
+        outcome.touched.push_back(bin);
+    }
+}
+
+Neighbourhood::Pose Neighbourhood::poseOf(std::size_t item) const {
+    const Item& it = packer.items[item];
+    return {item, it.getPosition(), it.getRotationType(), bin_of[item]};
+}
+
+bool Neighbourhood::movable(std::size_t bin, std::size_t item) const {
+    if (bin_of[item] != static_cast<long>(bin)) {
+        return false;
+    }
+    if (packer.getOptions().min_support <= 0) {
+        return true;
+    }
+    // Taking it out would leave whatever rests on it unsupported
+    const Bin& b = packer.bins[bin];
+    const auto& items = b.getItems();
+    for (std::size_t slot = 0; slot < items.size(); ++slot) {
+        if (&items[slot].get() == &packer.items[item]) {
+            return b.getSupportGraph().above(slot).empty();
+        }
+    }
+    return false;
+}
+
+void Neighbourhood::take(Outcome& outcome, std::size_t bin, std::size_t item) {
+    Bin& b = packer.bins[bin];
+    steps.push_back({Step::TAKE, bin, item, b.getItems(), {poseOf(item)}});
+    b.removeItem(packer.items[item]);
+    bin_of[item] = UNFIT;
+    outcome.volume -= volumeOf(item);
+    outcome.bins -= b.getItems().empty() ? 1 : 0;
+    touch(outcome, bin);
+}
+
+bool Neighbourhood::put(Outcome& outcome, std::size_t bin, std::size_t item, bool best_fit,
+                        const std::optional<std::tuple<long, long, long>>& corner) {
+    Bin& b = packer.bins[bin];
+    const bool was_empty = b.getItems().empty();
+    Pose before = poseOf(item);
+    // A slot just vacated is rarely an extreme point of what is left, so try it first
+    const bool placed = (corner && packer.placeItemAt(b, packer.items[item], *corner)) ||
+                        packer.placeItem(b, packer.items[item], best_fit);
+    if (!placed) {
+        // Trying poses moves the item even when none fits
+        steps.push_back({Step::POSE, bin, item, {}, {before}});
+        return false;
+    }
+    steps.push_back({Step::PUT, bin, item, {}, {before}});
+    bin_of[item] = static_cast<long>(bin);
+    outcome.volume += volumeOf(item);
+    outcome.bins += was_empty ? 1 : 0;
+    touch(outcome, bin);
+    return true;
+}
+
+bool Neighbourhood::putElsewhere(Outcome& outcome, std::size_t except, std::size_t item) {
+    for (std::size_t b = 0; b < packer.bins.size(); ++b) {
+        if (b != except && !packer.bins[b].getItems().empty() && put(outcome, b, item)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Neighbourhood::topUp(Outcome& outcome, std::size_t bin, std::size_t taken) {
+    std::vector<std::size_t> unfit;
+    for (std::size_t i = 0; i < bin_of.size(); ++i) {
+        if (bin_of[i] == UNFIT && i != taken) {
+            unfit.push_back(i);
+        }
+    }
+    std::stable_sort(unfit.begin(), unfit.end(), [this](std::size_t a, std::size_t b) {
+        return volumeOf(a) < volumeOf(b);
+    });
+    std::size_t attempts = 0;
+    for (std::size_t item : unfit) {
+        if (attempts++ == TOP_UP_ATTEMPTS) {
+            break;
+        }
+        if (put(outcome, bin, item)) {
+            outcome.filled.push_back(item);
+        }
+    }
+}
+
+Outcome Neighbourhood::apply(const Move& move) {
+    steps.clear();
+    Outcome outcome;
+    const bool has_unfit = move.kind != MoveKind::EMPTY_BIN;
+    if (has_unfit && bin_of[move.unfit] != UNFIT) {
+        return outcome;
+    }
+    const bool takes_item = move.kind == MoveKind::SWAP || move.kind == MoveKind::REORIENT ||
+                            move.kind == MoveKind::RELOCATE;
+    if (takes_item && !movable(move.bin, move.item)) {
+        return outcome;
+    }
+
+    const std::optional<std::tuple<long, long, long>> vacated =
+        takes_item ? std::optional<std::tuple<long, long, long>>(packer.items[move.item].getPosition()) : std::nullopt;
+    switch (move.kind) {
+        case MoveKind::INSERT:
+            outcome.feasible = put(outcome, move.bin, move.unfit);
+            break;
+        case MoveKind::SWAP:
+            // The item taken out may land anywhere again, or stay out
+            take(outcome, move.bin, move.item);
+            outcome.feasible = put(outcome, move.bin, move.unfit, false, vacated);
+            if (outcome.feasible && !put(outcome, move.bin, move.item)) {
+                putElsewhere(outcome, move.bin, move.item);
+            }
+            break;
+        case MoveKind::REORIENT:
+            take(outcome, move.bin, move.item);
+            outcome.feasible = put(outcome, move.bin, move.item, true) && put(outcome, move.bin, move.unfit);
+            break;
+        case MoveKind::RELOCATE:
+            take(outcome, move.bin, move.item);
+            outcome.feasible = putElsewhere(outcome, move.bin, move.item) && put(outcome, move.bin, move.unfit, false, vacated);
+            break;
+        case MoveKind::EMPTY_BIN: {
+            Bin& b = packer.bins[move.bin];
+            std::vector<std::size_t> taken;
+            for (const auto& ref : b.getItems()) {
+                const Item* item = &ref.get();
+                if (item < packer.items.data() || item >= packer.items.data() + packer.items.size()) {
+                    return outcome;
+                }
+                taken.push_back(static_cast<std::size_t>(item - packer.items.data()));
+            }
+            if (taken.empty()) {
+                return outcome;
+            }
+            steps.push_back({Step::CLEAR, move.bin, 0, b.getItems(), {}});
+            for (std::size_t item : taken) {
+                steps.back().poses.push_back(poseOf(item));
+                bin_of[item] = UNFIT;
+                outcome.volume -= volumeOf(item);
+            }
+            b.setItems({});
+            outcome.bins -= 1;
+            touch(outcome, move.bin);
+
+            // Largest first, as pack() would place them
+            std::stable_sort(taken.begin(), taken.end(), [this](std::size_t a, std::size_t c) {
+                return volumeOf(a) > volumeOf(c);
+            });
+            outcome.feasible = true;
+            for (std::size_t item : taken) {
+                if (!putElsewhere(outcome, move.bin, item)) {
+                    outcome.feasible = false;
+                    break;
+                }
+            }
+            break;
+        }
+    }
+    if (outcome.feasible && has_unfit) {
+        outcome.filled.push_back(move.unfit);
+    }
+    if (outcome.feasible && takes_item) {
+        topUp(outcome, move.bin, move.item);
+    }
+    return outcome;
+}
+
+void Neighbourhood::undo() {
+    auto restore = [this](const std::vector<Pose>& poses) {
+        for (const Pose& pose : poses) {
+            Item& item = packer.items[pose.item];
+            item.setPosition(pose.position);
+            item.setRotationType(pose.rotation);
+            bin_of[pose.item] = pose.bin;
+        }
+    };
+    for (auto step = steps.rbegin(); step != steps.rend(); ++step) {
+        Bin& b = packer.bins[step->bin];
+        if (step->kind == Step::PUT) {
+            // Steps are undone latest first, so the item is the bin's last
+            b.removeItem(packer.items[step->item]);
+            restore(step->poses);
+        } else if (step->kind == Step::POSE) {
+            restore(step->poses);
+        } else {
+            restore(step->poses);
+            b.setItems(step->before);
+        }
+    }
+    steps.clear();
+}
+
+// Sample a round of moves on the current solution
+std::vector<Move> sampleMoves(const Neighbourhood& state, std::size_t count, std::mt19937& rng) {
+    std::vector<std::size_t> unfit;
+    for (std::size_t i = 0; i < state.bin_of.size(); ++i) {
+        if (state.bin_of[i] == UNFIT) {
+            unfit.push_back(i);
+        }
+    }
+    std::vector<std::size_t> used;
+    std::vector<std::vector<std::size_t>> contents(state.packer.bins.size());
+    for (std::size_t i = 0; i < state.bin_of.size(); ++i) {
+        if (state.bin_of[i] != UNFIT) {
+            contents[static_cast<std::size_t>(state.bin_of[i])].push_back(i);
+        }
+    }
+    for (std::size_t b = 0; b < contents.size(); ++b) {
+        if (!contents[b].empty()) {
+            used.push_back(b);
+        }
+    }
+    // Emptying is tried on the least filled bins first
+    std::vector<std::size_t> emptiest = used;
+    std::stable_sort(emptiest.begin(), emptiest.end(), [&state](std::size_t a, std::size_t b) {
+        return state.packer.bins[a].getUsedVolume() < state.packer.bins[b].getUsedVolume();
+    });
+
+    std::vector<Move> moves;
+    if (used.empty()) {
+        return moves;
+    }
+    auto pick = [&rng](const std::vector<std::size_t>& from) {
+        return from[std::uniform_int_distribution<std::size_t>(0, from.size() - 1)(rng)];
+    };
+    std::size_t next_emptiest = 0;
+    for (std::size_t k = 0; k < count; ++k) {
+        const MoveKind kind = static_cast<MoveKind>(k % 5);
+        if (kind == MoveKind::EMPTY_BIN || unfit.empty()) {
+            if (used.size() > 1 && next_emptiest < emptiest.size()) {
+                moves.push_back({MoveKind::EMPTY_BIN, emptiest[next_emptiest++], 0, 0});
+            }
+            continue;
+        }
+        const std::size_t bin = pick(used);
+        const std::size_t in = pick(unfit);
+        std::size_t out = pick(contents[bin]);
+        if (kind == MoveKind::SWAP) {
+            // Only a smaller item makes room for a gain
+            std::vector<std::size_t> smaller;
+            for (std::size_t item : contents[bin]) {
+                if (state.packer.items[item].getVolume() < state.packer.items[in].getVolume()) {
+                    smaller.push_back(item);
+                }
+            }
+            if (smaller.empty()) {
+                continue;
+            }
+            out = pick(smaller);
+        }
+        if (kind == MoveKind::RELOCATE && used.size() < 2) {
+            continue;
+        }
+        moves.push_back({kind, bin, out, in});
+    }
+    return moves;
+}
+
+}  // namespace
+
+ImproveResult improvePacking(Packer& packer, const ImproveOptions& options) {
+    ImproveResult result;
+    result.packed_volume_before = packedVolume(packer);
+    result.bins_used_before = binsUsed(packer);
+
+    const PackOptions& pack_options = packer.getOptions();
+    auto stop_time = std::chrono::steady_clock::now() + options.budget;
+    if (pack_options.deadline) {
+        stop_time = std::min(stop_time, *pack_options.deadline);
+    }
+    auto shouldStop = [&]() {
+        return (pack_options.cancel && pack_options.cancel->isCancelled()) || std::chrono::steady_clock::now() >= stop_time;
+    };
+
+    const std::size_t worker_count = std::max<std::size_t>(1, options.threads);
+    Neighbourhood master(packer);
+    std::vector<std::unique_ptr<Neighbourhood>> workers;
+    for (std::size_t w = 0; w < worker_count; ++w) {
+        workers.push_back(std::make_unique<Neighbourhood>(packer));
+    }
+
+    {
+        WorkPool pool(worker_count);
+        std::mt19937 rng(options.seed);
+        std::size_t idle_rounds = 0;
+        while (idle_rounds < std::max<std::size_t>(1, options.max_idle_rounds) && !shouldStop()) {
+            const std::vector<Move> moves = sampleMoves(master, std::max<std::size_t>(1, options.moves_per_round), rng);
+            ++result.rounds;
+            if (moves.empty()) {
+                break;
+            }
+
+            // Every move is tried and undone on some worker's copy
+            std::vector<Outcome> outcomes(moves.size());
+            std::vector<std::future<void>> done;
+            for (std::size_t m = 0; m < moves.size(); ++m) {
+                auto finished = std::make_shared<std::promise<void>>();
+                done.push_back(finished->get_future());
+                pool.submit([&, m, finished](std::size_t worker) {
+                    try {
+                        outcomes[m] = workers[worker]->apply(moves[m]);
+                        workers[worker]->undo();
+                        finished->set_value();
+                    } catch (...) {
+                        finished->set_exception(std::current_exception());
+                    }
+                });
+            }
+            for (auto& future : done) {
+                future.get();
+            }
+            result.evaluated += moves.size();
+
+            // Keep the improving moves best first, skipping any that share a
+            // bin or an unfit item with one already kept
+            std::vector<std::size_t> order;
+            for (std::size_t m = 0; m < moves.size(); ++m) {
+                if (improves(outcomes[m], options.objective)) {
+                    order.push_back(m);
+                }
+            }
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                return better(outcomes[a], outcomes[b], options.objective);
+            });
+            std::vector<bool> bin_taken(packer.bins.size(), false);
+            std::vector<bool> item_taken(master.bin_of.size(), false);
+            std::size_t accepted = 0;
+            for (std::size_t m : order) {
+                const Move& move = moves[m];
+                bool clash = false;
+                for (std::size_t item : outcomes[m].filled) {
+                    clash = clash || item_taken[item];
+                }
+                for (std::size_t bin : outcomes[m].touched) {
+                    clash = clash || bin_taken[bin];
+                }
+                if (clash) {
+                    continue;
+                }
+                // The other bins are as the move saw them, but check anyway
+                if (!improves(master.apply(move), options.objective)) {
+                    master.undo();
+                    continue;
+                }
+                for (std::size_t bin : outcomes[m].touched) {
+                    bin_taken[bin] = true;
+                }
+                for (std::size_t item : outcomes[m].filled) {
+                    item_taken[item] = true;
+                }
+                ++accepted;
+            }
+            result.accepted += accepted;
+            idle_rounds = accepted == 0 ? idle_rounds + 1 : 0;
+
+            if (accepted > 0) {
+                for (auto& worker : workers) {
+                    worker->sync(master.packer);
+                }
+            }
+        }
+    }
+
+    packer = master.packer;
+    packer.unfit_items.clear();
+    for (std::size_t i = 0; i < master.bin_of.size(); ++i) {
+        if (master.bin_of[i] == UNFIT) {
+            packer.unfit_items.push_back(packer.items[i]);
+        }
+    }
+    result.packed_volume_after = packedVolume(packer);
+    result.bins_used_after = binsUsed(packer);
+    return result;
+}
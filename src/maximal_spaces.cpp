@@ -0,0 +1,143 @@
+#include "maximal_spaces.h"
+#include <algorithm>
+
+static bool overlaps(const GridBox& a, const GridBox& b) {
+    return a.min[0] < b.max[0] && b.min[0] < a.max[0] &&
+           a.min[1] < b.max[1] && b.min[1] < a.max[1] &&
+           a.min[2] < b.max[2] && b.min[2] < a.max[2];
+}
+
+static bool contains(const GridBox& outer, const GridBox& inner) {
+    return outer.min[0] <= inner.min[0] && inner.max[0] <= outer.max[0] &&
+           outer.min[1] <= inner.min[1] && inner.max[1] <= outer.max[1] &&
+           outer.min[2] <= inner.min[2] && inner.max[2] <= outer.max[2];
+}
+
+MaximalSpaceSet::MaximalSpaceSet() : largest{0, 0, 0} {}
+
+void MaximalSpaceSet::clear(const Extent& extent) {
+    free_spaces.assign(1, GridBox{{0, 0, 0}, extent});
+    removed.clear();
+    journal.clear();
+    largest = extent;
+}
+
+void MaximalSpaceSet::push(const GridBox& box) {
+    JournalEntry record{static_cast<uint32_t>(removed.size()), 0};
+
+    // Keep the spaces the box misses in place; split the others into the
+    // slabs on either side of the box along each axis
+    pieces.clear();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < free_spaces.size(); ++i) {
+        const GridBox space = free_spaces[i];
+        if (!overlaps(space, box)) {
+            free_spaces[kept++] = space;
+            continue;
+        }
+        removed.push_back({static_cast<uint32_t>(i), space});
+        for (int axis = 0; axis < 3; ++axis) {
+            if (space.min[axis] < box.min[axis]) {
+                GridBox slab = space;
+                slab.max[axis] = box.min[axis];
+                pieces.push_back(slab);
+            }
+            if (box.max[axis] < space.max[axis]) {
+                GridBox slab = space;
+                slab.min[axis] = box.max[axis];
+                pieces.push_back(slab);
+            }
+        }
+    }
+    free_spaces.resize(kept);
+
+    // A slab inside a kept space or another slab is not maximal. Kept spaces
+    // never lie inside a slab, as each slab lies inside a space that was maximal.
+    for (std::size_t k = 0; k < pieces.size(); ++k) {
+        bool dominated = false;
+        for (std::size_t i = 0; i < kept && !dominated; ++i) {
+            dominated = contains(free_spaces[i], pieces[k]);
+        }
+        for (std::size_t j = 0; j < pieces.size() && !dominated; ++j) {
+            // Of two equal slabs the first one stays
+            dominated = j != k && contains(pieces[j], pieces[k]) && (j < k || !contains(pieces[k], pieces[j]));
+        }
+        if (!dominated) {
+            free_spaces.push_back(pieces[k]);
+            ++record.added;
+        }
+    }
+
+    journal.push_back(record);
+    updateLargest();
+}
+
+void MaximalSpaceSet::pop() {
+    if (journal.empty()) {
+        return;
+    }
+    JournalEntry record = journal.back();
+    journal.pop_back();
+
+    // Drop the slabs, then merge the split spaces back into their old slots
+    free_spaces.resize(free_spaces.size() - record.added);
+    merged.clear();
+    std::size_t next_removed = record.first_removed;
+    std::size_t next_kept = 0;
+    while (next_kept < free_spaces.size() || next_removed < removed.size()) {
+        if (next_removed < removed.size() && removed[next_removed].index == merged.size()) {
+            merged.push_back(removed[next_removed++].space);
+        } else {
+            merged.push_back(free_spaces[next_kept++]);
+        }
+    }
+    free_spaces.swap(merged);
+    removed.resize(record.first_removed);
+    updateLargest();
+}
+
+std::size_t MaximalSpaceSet::depth() const {
+    return journal.size();
+}
+
+std::size_t MaximalSpaceSet::size() const {
+    return free_spaces.size();
+}
+
+const std::vector<GridBox>& MaximalSpaceSet::spaces() const {
+    return free_spaces;
+}
+
+std::optional<GridBox> MaximalSpaceSet::best(const Extent& dimension) const {
+    std::optional<GridBox> found;
+    forEachFitting(dimension, [&found](const GridBox& space) {
+        if (!found || nearer(space.min, found->min)) {
+            found = space;
+        }
+    });
+    return found;
+}
+
+bool MaximalSpaceSet::nearer(const Extent& a, const Extent& b) {
+    long distance_a = a[0] + a[1] + a[2];
+    long distance_b = b[0] + b[1] + b[2];
+    if (distance_a != distance_b) {
+        return distance_a < distance_b;
+    }
+    if (a[1] != b[1]) {
+        return a[1] < b[1];
+    }
+    if (a[2] != b[2]) {
+        return a[2] < b[2];
+    }
+    return a[0] < b[0];
+}
+
+void MaximalSpaceSet::updateLargest() {
+    largest = {0, 0, 0};
+    for (const GridBox& space : free_spaces) {
+        for (int axis = 0; axis < 3; ++axis) {
+            largest[axis] = std::max(largest[axis], space.max[axis] - space.min[axis]);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include "orientations.h"
+#include <cmath>
+
+float orientationScore(const std::array<long, 3>& d, const std::array<long, 3>& extent) {
+    if (extent[0] < d[0] || extent[1] < d[1] || extent[2] < d[2]) {
+        return 0;
+    }
+    float widthScore = std::pow(static_cast<float>(d[0]) / extent[0], 2);
+    float heightScore = std::pow(static_cast<float>(d[1]) / extent[1], 2);
+    float depthScore = std::pow(static_cast<float>(d[2]) / extent[2], 2);
+
+    float score = widthScore + heightScore + depthScore;
+    return score;
+}
+
+OrientationTable buildOrientationTable(const Item& item, const std::array<long, 3>& extent) {
+    OrientationTable table;
+    const auto& allowed = item.getAllowedRotations();
+    if (!allowed.empty()) {
+        table.best = allowed[0];
+    }
+
+    // Score every allowed rotation once; on a tie the lower RotationType wins
+    std::array<bool, ROTATION_COUNT> is_allowed{};
+    for (auto rotation : allowed) {
+        is_allowed[static_cast<std::size_t>(rotation)] = true;
+    }
+    float best_score = 0;
+    for (std::size_t r = 0; r < ROTATION_COUNT; ++r) {
+        if (!is_allowed[r]) {
+            continue;
+        }
+        RotationType rotation = static_cast<RotationType>(r);
+        auto dimension = rotateDimension(item.getWidth(), item.getHeight(), item.getDepth(), rotation);
+        float score = orientationScore(dimension, extent);
+        if (dimension[0] <= extent[0] && dimension[1] <= extent[1] && dimension[2] <= extent[2]) {
+            table.fitting |= uint8_t(1u << r);
+        }
+        if (score > best_score) {
+            best_score = score;
+            table.best = rotation;
+        }
+
+        bool seen = false;
+        for (const Orientation& orientation : table) {
+            seen = seen || orientation.dimension == dimension;
+        }
+        if (!seen) {
+            table.orientations[table.count++] = {rotation, dimension, score};
+        }
+    }
+    return table;
+}
+
+bool OrientationCache::Key::operator==(const Key& other) const {
+    return size == other.size && allowed == other.allowed && first == other.first;
+}
+
+std::size_t OrientationCache::KeyHash::operator()(const Key& key) const {
+    std::size_t h = std::hash<long>()(key.size[0]);
+    h = h * 1000003u ^ std::hash<long>()(key.size[1]);
+    h = h * 1000003u ^ std::hash<long>()(key.size[2]);
+    return h * 1000003u ^ (static_cast<std::size_t>(key.allowed) << 3 | static_cast<std::size_t>(key.first));
+}
+
+const OrientationTable& OrientationCache::lookup(const Item& item, const std::array<long, 3>& extent) {
+    if (extent != cached_extent) {
+        tables.clear();
+        cached_extent = extent;
+    }
+
+    const auto& allowed = item.getAllowedRotations();
+    Key key{{item.getWidth(), item.getHeight(), item.getDepth()}, 0,
+            allowed.empty() ? RotationType::whd : allowed[0]};
+    for (auto rotation : allowed) {
+        key.allowed |= uint8_t(1u << static_cast<int>(rotation));
+    }
+
+    auto it = tables.find(key);
+    if (it == tables.end()) {
+        it = tables.emplace(key, buildOrientationTable(item, extent)).first;
+    }
+    return it->second;
+}
@@ -0,0 +1,63 @@
+#include "pack_columns.h"
+#include <string>
+#include <vector>
+
+// Allowed rotations for a mask, bit r standing for RotationType r
+static std::vector<RotationType> rotationsFromMask(uint8_t mask) {
+    std::vector<RotationType> rotations;
+    for (std::size_t r = 0; r < ROTATION_COUNT; ++r) {
+        if (mask & (1u << r)) {
+            rotations.push_back(static_cast<RotationType>(r));
+        }
+    }
+    return rotations;
+}
+
+void packColumns(Packer& packer, const BinColumns& bins, const ItemColumns& items, PlacementRecord* out) {
+    // Refill the packer in place so its vectors keep their capacity
+    packer.reset();
+    packer.bins.reserve(bins.count);
+    for (std::size_t i = 0; i < bins.count; ++i) {
+        const long* dim = bins.dimensions + 3 * i;
+        packer.bins.emplace_back(std::to_string(i), dim[0], dim[1], dim[2],
+                                 bins.max_weight ? bins.max_weight[i] : 0.0f);
+        packer.bins.back().input_index = i;
+    }
+
+    packer.items.reserve(items.count);
+    for (std::size_t i = 0; i < items.count; ++i) {
+        const long* dim = items.dimensions + 3 * i;
+        packer.items.emplace_back(std::to_string(i), dim[0], dim[1], dim[2],
+                                  rotationsFromMask(items.rotation_mask ? items.rotation_mask[i] : 0),
+                                  "", items.weight ? items.weight[i] : 0.0f,
+                                  items.stuffing_layers ? items.stuffing_layers[i] : 0,
+                                  items.stuffing_max_weight ? items.stuffing_max_weight[i] : 0.0f,
+                                  items.stuffing_height ? items.stuffing_height[i] : 0,
+                                  items.bottom_load_only && items.bottom_load_only[i],
+                                  items.disable_stacking && items.disable_stacking[i]);
+        Item& item = packer.items.back();
+        item.input_index = i;
+        if (items.max_height && items.max_height[i] > 0) {
+            item.setHeightConstraint(true, items.max_height[i]);
+        }
+    }
+
+    packer.pack();
+
+    // pack() sorts bins and items, so write records by input row
+    for (std::size_t i = 0; i < items.count; ++i) {
+        out[i] = {static_cast<int64_t>(i), -1, 0, 0, 0, 0};
+    }
+    for (const auto& bin : packer.getBins()) {
+        for (const auto& ref : bin.getItems()) {
+            const Item& item = ref.get();
+            const auto& [x, y, z] = item.getPosition();
+            PlacementRecord& record = out[item.input_index];
+            record.bin = static_cast<int64_t>(bin.input_index);
+            record.x = x;
+            record.y = y;
+            record.z = z;
+            record.rotation = static_cast<int32_t>(item.getRotationType());
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include "pack_service.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+PackService::PackService(std::size_t workers)
+    : packers(std::max<std::size_t>(1, workers)), pool(std::max<std::size_t>(1, workers)) {}
+
+std::size_t PackService::workerCount() const {
+    return pool.size();
+}
+
+PackResult PackService::packJob(Packer& packer, const PackJob& job) {
+    // Refill the packer in place so its vectors keep their capacity
+    packer.reset();
+    packer.bins.assign(job.bins.begin(), job.bins.end());
+    packer.items.assign(job.items.begin(), job.items.end());
+    for (std::size_t i = 0; i < packer.bins.size(); ++i) {
+        // Bins are packed empty; items they hold belong to the caller
+        packer.bins[i].setItems({});
+        packer.bins[i].input_index = i;
+    }
+    for (std::size_t i = 0; i < packer.items.size(); ++i) {
+        packer.items[i].input_index = i;
+    }
+
+    packer.pack();
+
+    // pack() sorts bins and items, so report them by input position
+    PackResult result;
+    for (const auto& bin : packer.getBins()) {
+        for (const auto& ref : bin.getItems()) {
+            const Item& item = ref.get();
+            result.placements.push_back({item.input_index, bin.input_index, item.getPosition(), item.getRotationType()});
+        }
+    }
+    for (const auto& item : packer.getUnfitItems()) {
+        result.unfit.push_back(item.input_index);
+    }
+    return result;
+}
+
+std::vector<std::future<PackResult>> PackService::packBatch(std::vector<PackJob> jobs) {
+    auto shared_jobs = std::make_shared<std::vector<PackJob>>(std::move(jobs));
+    std::vector<std::future<PackResult>> results;
+    results.reserve(shared_jobs->size());
+
+    for (std::size_t i = 0; i < shared_jobs->size(); ++i) {
+        auto promise = std::make_shared<std::promise<PackResult>>();
+        results.push_back(promise->get_future());
+        pool.submit([this, shared_jobs, promise, i](std::size_t worker) {
+            try {
+                promise->set_value(packJob(packers[worker], (*shared_jobs)[i]));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    }
+    return results;
+}
+
+void PackService::packBatch(std::vector<PackJob> jobs, const std::function<void(std::size_t, PackResult)>& done) {
+    struct Batch {
+        std::vector<PackJob> jobs;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::size_t remaining;
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->jobs = std::move(jobs);
+    batch->remaining = batch->jobs.size();
+
+    for (std::size_t i = 0; i < batch->jobs.size(); ++i) {
+        pool.submit([this, batch, &done, i](std::size_t worker) {
+            std::exception_ptr error;
+            try {
+                done(i, packJob(packers[worker], batch->jobs[i]));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (error && !batch->error) {
+                batch->error = error;
+            }
+            if (--batch->remaining == 0) {
+                batch->finished.notify_all();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&batch] { return batch->remaining == 0; });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
@@ -1,18 +1,175 @@
 #include "packer.h"
+#include "box_kernels.h"
 #include <algorithm> 
 #include <iostream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <vector>
 #include <functional>
 #include <map>
+#include <random>
 #include <chrono> // Add time-based early stopping
 
 const std::tuple<long, long, long> START_POSITION = {0, 0, 0};
 
-// Maximum time allowed for bin packing in milliseconds
-const int MAX_PACK_TIME_MS = 30000;  // Increased to 30 seconds for complex packing problems
+// Candidate positions bounds-checked together in packToBin
+const std::size_t CANDIDATE_BATCH = 16;
+
+// Share of its slab a layer must fill for the wall strategy to lay it
+const double MIN_WALL_FILL = 0.5;
 
 Packer::Packer() {}
 
+Packer::Packer(const Packer& other)
+    : items(other.items), bins(other.bins), unfit_items(other.unfit_items),
+      item_types(other.item_types), expanded_quantities(other.expanded_quantities),
+      type_ids(other.type_ids), online_items(other.online_items), open_bins(other.open_bins),
+      options(other.options) {
+    // Online arrivals are not contiguous, so map them one by one
+    std::unordered_map<const Item*, Item*> online_copies;
+    for (std::size_t i = 0; i < online_items.size(); ++i) {
+        online_copies[&other.online_items[i]] = &online_items[i];
+    }
+    for (const Item* item : other.online_buffer) {
+        online_buffer.push_back(online_copies.at(item));
+    }
+
+    // Bins still point at the other packer's items; point them at ours
+    for (auto& bin : bins) {
+        std::vector<std::reference_wrapper<Item>> relinked;
+        relinked.reserve(bin.getItems().size());
+        for (const auto& ref : bin.getItems()) {
+            const Item* item = &ref.get();
+            auto online = online_copies.find(item);
+            if (!other.items.empty() && item >= other.items.data() && item < other.items.data() + other.items.size()) {
+                relinked.push_back(std::ref(items[item - other.items.data()]));
+            } else if (online != online_copies.end()) {
+                relinked.push_back(std::ref(*online->second));
+            } else {
+                relinked.push_back(ref);
+            }
+        }
+        bin.setItems(relinked);
+    }
+}
+
+Packer& Packer::operator=(const Packer& other) {
+    if (this != &other) {
+        Packer copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+void Packer::reset() {
+    bins.clear();
+    items.clear();
+    unfit_items.clear();
+    item_types.clear();
+    expanded_quantities.clear();
+    type_ids.clear();
+    online_items.clear();
+    online_buffer.clear();
+    open_bins.clear();
+    bin_index = BinIndex();
+}
+
+void Packer::setOptions(const PackOptions& options) {
+    this->options = options;
+}
+
+const PackOptions& Packer::getOptions() const {
+    return options;
+}
+
+PackStop Packer::getStopReason() const {
+    return stop_reason;
+}
+
+PackProgress Packer::getProgress() const {
+    PackProgress progress;
+    progress.items_unfit = unfit_items.size();
+    progress.items_total = items.size() + online_items.size();
+    double used_volume = 0;
+    double opened_volume = 0;
+    for (const auto& bin : bins) {
+        if (bin.getItems().empty()) {
+            continue;
+        }
+        progress.items_placed += bin.getItems().size();
+        progress.bins_opened += 1;
+        used_volume += static_cast<double>(bin.getUsedVolume());
+        opened_volume += static_cast<double>(bin.getVolume());
+    }
+    progress.fill_rate = opened_volume > 0 ? used_volume / opened_volume : 0;
+    return progress;
+}
+
+bool Packer::shouldStop() {
+    if (options.cancel && options.cancel->isCancelled()) {
+        stop_reason = PackStop::CANCELLED;
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now > stop_time || (options.deadline && now > *options.deadline)) {
+        stop_reason = PackStop::DEADLINE;
+        return true;
+    }
+    return false;
+}
+
+void Packer::reportProgress() const {
+    if (options.progress) {
+        options.progress(getProgress());
+    }
+}
+
+Packer::Checkpoint Packer::checkpoint() const {
+    Checkpoint checkpoint;
+    checkpoint.bin_marks.reserve(bins.size());
+    for (const auto& bin : bins) {
+        checkpoint.bin_marks.push_back(bin.checkpoint());
+    }
+    checkpoint.unfit_count = unfit_items.size();
+    checkpoint.poses.reserve(items.size());
+    for (const auto& item : items) {
+        checkpoint.poses.emplace_back(item.getPosition(), item.getRotationType());
+    }
+    return checkpoint;
+}
+
+void Packer::rollback(const Checkpoint& checkpoint) {
+    for (std::size_t i = 0; i < bins.size() && i < checkpoint.bin_marks.size(); ++i) {
+        bins[i].rollback(checkpoint.bin_marks[i]);
+    }
+    if (unfit_items.size() > checkpoint.unfit_count) {
+        unfit_items.erase(unfit_items.begin() + checkpoint.unfit_count, unfit_items.end());
+    }
+    for (std::size_t i = 0; i < items.size() && i < checkpoint.poses.size(); ++i) {
+        items[i].setPosition(checkpoint.poses[i].first);
+        items[i].setRotationType(checkpoint.poses[i].second);
+    }
+}
+
+PackerFork::PackerFork(Packer& packer) : packer(packer), checkpoint(packer.checkpoint()), committed(false) {}
+
+PackerFork::~PackerFork() {
+    if (!committed) {
+        packer.rollback(checkpoint);
+    }
+}
+
+void PackerFork::commit() {
+    committed = true;
+}
+
+void PackerFork::rollback() {
+    packer.rollback(checkpoint);
+    committed = false;
+}
+
 const std::vector<Bin>& Packer::getBins() const {
     return bins;
 }
@@ -33,9 +190,78 @@ void Packer::addItem(const Item& item) {
     items.push_back(item);
 }
 
+// Whether two prototypes describe the same SKU: everything but the pose
+static bool sameItemType(const Item& a, const Item& b) {
+    return a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight() && a.getDepth() == b.getDepth() &&
+           a.getAllowedRotations() == b.getAllowedRotations() && a.color == b.color && a.weight == b.weight &&
+           a.getStuffingLayers() == b.getStuffingLayers() &&
+           a.getStuffingMaxWeight() == b.getStuffingMaxWeight() &&
+           a.getStuffingHeight() == b.getStuffingHeight() &&
+           a.isHeightConstrained() == b.isHeightConstrained() &&
+           a.getHeightConstraintValue() == b.getHeightConstraintValue() &&
+           a.getHeightConstraintType() == b.getHeightConstraintType() &&
+           a.isBottomLoadOnlyEnabled() == b.isBottomLoadOnlyEnabled() &&
+           a.isDisableStackingEnabled() == b.isDisableStackingEnabled();
+}
+
+std::size_t Packer::addItemType(const Item& prototype, std::size_t quantity) {
+    auto [it, inserted] = type_ids.emplace(prototype.getName(), item_types.size());
+    if (inserted) {
+        item_types.push_back({prototype, quantity});
+        item_types.back().prototype.type_id = it->second;
+        expanded_quantities.push_back(0);
+    } else if (sameItemType(item_types[it->second].prototype, prototype)) {
+        item_types[it->second].quantity += quantity;
+    } else {
+        throw std::invalid_argument("item type " + prototype.getName() + " was added with other dimensions or constraints");
+    }
+    return it->second;
+}
+
+const std::vector<ItemType>& Packer::getItemTypes() const {
+    return item_types;
+}
+
+std::vector<std::size_t> Packer::getPackedQuantities() const {
+    std::vector<std::size_t> packed(item_types.size(), 0);
+    for (const auto& bin : bins) {
+        for (const auto& ref : bin.getItems()) {
+            std::size_t type_id = ref.get().type_id;
+            if (type_id < packed.size()) {
+                packed[type_id] += 1;
+            }
+        }
+    }
+    return packed;
+}
+
+void Packer::expandItemTypes() {
+    std::size_t pending = 0;
+    for (std::size_t k = 0; k < item_types.size(); ++k) {
+        pending += item_types[k].quantity - expanded_quantities[k];
+    }
+    items.reserve(items.size() + pending);
+    for (std::size_t k = 0; k < item_types.size(); ++k) {
+        items.insert(items.end(), item_types[k].quantity - expanded_quantities[k], item_types[k].prototype);
+        expanded_quantities[k] = item_types[k].quantity;
+    }
+}
+
+// Slot of an item in a bin, searching from the most recent placement; the
+// constraint checks run right after putItem, so this is normally the last one
+static std::optional<std::size_t> placedSlot(const Bin& bin, const Item& item) {
+    const auto& items = bin.getItems();
+    for (std::size_t slot = items.size(); slot-- > 0;) {
+        if (&items[slot].get() == &item) {
+            return slot;
+        }
+    }
+    return std::nullopt;
+}
+
 // Helper function to calculate overlap between items
-float Packer::calculateItemOverlap(const std::tuple<long, long, long>& pos1, const std::vector<long>& dim1,
-                                  const std::tuple<long, long, long>& pos2, const std::vector<long>& dim2) const {
+float Packer::calculateItemOverlap(const std::tuple<long, long, long>& pos1, const std::array<long, 3>& dim1,
+                                  const std::tuple<long, long, long>& pos2, const std::array<long, 3>& dim2) const {
     // Calculate overlap in X dimension
     float overlap_x = std::max(0.0f, 
         std::min(static_cast<float>(std::get<0>(pos1) + dim1[0]), 
@@ -57,9 +283,9 @@ float Packer::calculateItemOverlap(const std::tuple<long, long, long>& pos1, con
 // Helper function to check if an item is directly above another with significant overlap
 bool Packer::isItemDirectlyAbove(const Item& bottom_item, const Item& top_item, float overlap_threshold) const {
     const auto& bottom_pos = bottom_item.getPosition();
-    const auto& bottom_dim = bottom_item.getDimension();
+    const auto bottom_dim = bottom_item.getGeometry().dimension;
     const auto& top_pos = top_item.getPosition();
-    const auto& top_dim = top_item.getDimension();
+    const auto top_dim = top_item.getGeometry().dimension;
     
     // Check if top item's bottom face is at or above the bottom item's top face
     if (std::get<1>(top_pos) < std::get<1>(bottom_pos) + bottom_dim[1]) {
@@ -87,92 +313,52 @@ bool Packer::checkStuffingConstraints(const Bin& bin, const Item& item, const st
         return true;
     }
     
-    // Get item dimensions with current rotation
-    const auto& item_dim = item.getDimension();
-    float overlap_threshold = 0.5; // 50% overlap required to consider an item "above" another
-    
-    // Check height constraint for both stuffing height and direct height constraint
-    long top_of_item = std::get<1>(position) + item_dim[1];
+    // The item has been put in the bin; its support links hold everything above it
+    auto slot = placedSlot(bin, item);
+    if (!slot) {
+        return true;
+    }
+    const SupportGraph& support = bin.getSupportGraph();
+    const PlacedBoxes& boxes = bin.getPlacedBoxes();
+    const float item_area = static_cast<float>(boxes.baseArea(*slot));
     
     // If height is constrained (isHeight=true) or disable_stacking is true, 
     // ensure nothing is stacked above this item
     if (item.isHeightConstrained() || item.isDisableStackingEnabled()) {
-        for (const auto& other_item : bin.getItems()) {
-            // Skip comparing with itself
-            if (&other_item.get() == &item) {
-                continue;
-            }
-            
-            if (isItemDirectlyAbove(item, other_item.get(), 0.1f)) { // Even small overlap should prevent stacking
+        for (const SupportEdge& edge : support.above(*slot)) {
+            // Even small overlap should prevent stacking
+            if (edge.overlap >= 0.1f * item_area) {
                 // If item is height constrained or has disable_stacking, no items should be above it
                 return false;
             }
         }
     }
     
+    // Items resting on this one cover at least half of its footprint
+    std::size_t layer_count = support.layersAbove(*slot);
+    
     // Check stuffing height constraint - interpret as EXACT height allowed for stacking
     if (item.getStuffingHeight() > 0) {
-        long max_allowed_height = top_of_item + item.getStuffingHeight();
-        bool has_items_above = false;
+        long max_allowed_height = boxes.max_y[*slot] + item.getStuffingHeight();
         
-        // Find all items above this one
-        for (const auto& other_item : bin.getItems()) {
-            // Skip comparing with itself
-            if (&other_item.get() == &item) {
-                continue;
-            }
-            
-            const auto& other_pos = other_item.get().getPosition();
-            const auto& other_dim = other_item.get().getDimension();
-            
-            // Only check items that could be above (quick vertical position check)
-            if (std::get<1>(other_pos) < top_of_item) {
-                continue;
-            }
-            
-            // Check if item is above with significant overlap
-            if (isItemDirectlyAbove(item, other_item.get(), overlap_threshold)) {
-                has_items_above = true;
-                // Check if any item would exceed the allowed height
-                if (std::get<1>(other_pos) + other_dim[1] > max_allowed_height) {
-                    return false;
-                }
-            }
+        // Check if any item above would exceed the allowed height
+        if (layer_count > 0 && support.topAbove(*slot) > max_allowed_height) {
+            return false;
         }
         
         // If height value is a specific constraint (not being used for placement logic),
         // then we require items to be exactly at that height (not empty space)
-        if (item.getHeightConstraintType() == HeightConstraintType::EXACT && !has_items_above) {
+        if (item.getHeightConstraintType() == HeightConstraintType::EXACT && layer_count == 0) {
             return false;
         }
     }
     
     // Check for items above that might violate stuffing layer constraints
     if (item.getStuffingLayers() > 0) {
-        // Create a map to track layers by height position
-        std::map<long, bool> layer_heights;
-        
-        for (const auto& other_item : bin.getItems()) {
-            // Skip comparing with itself
-            if (&other_item.get() == &item) {
-                continue;
-            }
-            
-            const auto& other_pos = other_item.get().getPosition();
-            
-            // Check if the other item is directly above this one
-            if (isItemDirectlyAbove(item, other_item.get(), overlap_threshold)) {
-                // Add this layer height to our map
-                layer_heights[std::get<1>(other_pos)] = true;
-            }
-        }
-        
-        int layer_count = static_cast<int>(layer_heights.size());
-        
         // Apply constraint based on constraint type
         if (item.getHeightConstraintType() == HeightConstraintType::EXACT) {
             // For items that require EXACTLY the specified number of layers
-            if (layer_count != item.getStuffingLayers()) {
+            if (static_cast<int>(layer_count) != item.getStuffingLayers()) {
                 // This is a problematic constraint - log it
                 std::cout << "Rejecting item due to EXACT layer constraint: has " << layer_count 
                           << " layers but needs " << item.getStuffingLayers() << std::endl;
@@ -180,7 +366,7 @@ bool Packer::checkStuffingConstraints(const Bin& bin, const Item& item, const st
             }
         } else {
             // For MAXIMUM type, don't exceed the specified layers
-            if (layer_count > item.getStuffingLayers()) {
+            if (static_cast<int>(layer_count) > item.getStuffingLayers()) {
                 std::cout << "Rejecting item due to MAX layer constraint: has " << layer_count 
                           << " layers but max is " << item.getStuffingLayers() << std::endl;
                 return false; // Violated constraint - too many layers
@@ -189,198 +375,145 @@ bool Packer::checkStuffingConstraints(const Bin& bin, const Item& item, const st
     }
     
     // Check stuffing weight constraint
-    if (item.getStuffingMaxWeight() > 0) {
-        float total_weight_above = 0.0f;
-        
-        for (const auto& other_item : bin.getItems()) {
-            // Skip comparing with itself
-            if (&other_item.get() == &item) {
-                continue;
-            }
-            
-            // Check if item is directly above
-            if (isItemDirectlyAbove(item, other_item.get(), overlap_threshold)) {
-                total_weight_above += other_item.get().weight;
-                
-                // Early exit if weight is already exceeded
-                if (total_weight_above > item.getStuffingMaxWeight()) {
-                    return false;
-                }
-            }
-        }
+    if (item.getStuffingMaxWeight() > 0 && support.loadAbove(*slot) > item.getStuffingMaxWeight()) {
+        return false;
     }
     
     return true;
 }
 
 // Helper function to check if this item would violate another item's constraints
-bool Packer::wouldViolateExistingItemConstraints(const Bin& bin, const Item& new_item, const std::tuple<long, long, long>& new_position) {
-    const auto& new_dim = new_item.getDimension();
-    float overlap_threshold = 0.5;
+bool Packer::wouldViolateExistingItemConstraints(const Bin& bin, const Item& new_item) {
+    // The new item has been put in the bin; only the items it lies on can be affected
+    auto slot = placedSlot(bin, new_item);
+    if (!slot) {
+        return false;
+    }
+    const SupportGraph& support = bin.getSupportGraph();
+    const PlacedBoxes& boxes = bin.getPlacedBoxes();
+    const long new_top = boxes.max_y[*slot];
 
-    for (const auto& existing_item : bin.getItems()) {
-        // Skip for self
-        if (&existing_item.get() == &new_item) {
+    for (const SupportEdge& edge : support.below(*slot)) {
+        // Items without constraints are filtered on the packed flags alone
+        uint8_t flags = boxes.flags[edge.index];
+        if (flags == 0) {
             continue;
         }
         
-        // Check if existing item is height constrained - no items can be stacked on it
-        if (existing_item.get().isHeightConstrained()) {
-            // Check if new item would be above existing item with any overlap
-            const auto& existing_pos = existing_item.get().getPosition();
-            const auto& existing_dim = existing_item.get().getDimension();
-            
-            // Calculate overlap area
-            float area_overlap = calculateItemOverlap(existing_pos, existing_dim, new_position, new_dim);
-            
-            // If new item would be placed above a height-constrained item (with ANY overlap), return true
-            if (std::get<1>(new_position) >= std::get<1>(existing_pos) + existing_dim[1] &&
-                area_overlap > 0) {
-                return true; // Cannot place items above height-constrained items
-            }
-        }
-        
-        // Check if existing item has disable_stacking enabled
-        if (existing_item.get().isDisableStackingEnabled()) {
-            // Check if new item would be above existing item with any overlap
-            const auto& existing_pos = existing_item.get().getPosition();
-            const auto& existing_dim = existing_item.get().getDimension();
-            
-            // Calculate overlap area
-            float area_overlap = calculateItemOverlap(existing_pos, existing_dim, new_position, new_dim);
-            
-            // If new item would be placed above a disable-stacking item (with ANY overlap), return true
-            if (std::get<1>(new_position) >= std::get<1>(existing_pos) + existing_dim[1] &&
-                area_overlap > 0) {
-                return true; // Cannot place items above disable-stacking items
-            }
+        // No items can be stacked on a height-constrained or disable-stacking item
+        // (with ANY overlap)
+        if ((flags & (PLACED_HEIGHT_CONSTRAINED | PLACED_DISABLE_STACKING)) && edge.overlap > 0) {
+            return true;
         }
         
-        // Skip items without other stuffing constraints
-        if (existing_item.get().getStuffingLayers() <= 0 && 
-            existing_item.get().getStuffingMaxWeight() <= 0 && 
-            existing_item.get().getStuffingHeight() <= 0) {
+        // Skip items without other stuffing constraints, or that the new item only grazes
+        if (!(flags & PLACED_STUFFING_LIMITS) || !edge.resting) {
             continue;
         }
+        const Item& existing_item = bin.getItems()[edge.index].get();
         
-        const auto& existing_pos = existing_item.get().getPosition();
-        const auto& existing_dim = existing_item.get().getDimension();
-        
-        // Check if new item would be above existing item (with overlap)
-        // Calculate overlap area
-        float area_overlap = calculateItemOverlap(existing_pos, existing_dim, new_position, new_dim);
-        float area_existing = static_cast<float>(existing_dim[0] * existing_dim[2]);
+        // Check height constraint
+        if (existing_item.getStuffingHeight() > 0 &&
+            new_top > boxes.max_y[edge.index] + existing_item.getStuffingHeight()) {
+            return true; // Exceeds allowed height
+        }
         
-        // If new item would be placed above an existing item
-        if (std::get<1>(new_position) >= std::get<1>(existing_pos) + existing_dim[1] &&
-            area_overlap >= overlap_threshold * area_existing) {
-            
-            // Check height constraint
-            if (existing_item.get().getStuffingHeight() > 0) {
-                long max_allowed_height = std::get<1>(existing_pos) + existing_dim[1] + 
-                                         existing_item.get().getStuffingHeight();
-                                         
-                if (std::get<1>(new_position) + new_dim[1] > max_allowed_height) {
-                    return true; // Exceeds allowed height
-                }
-            }
-            
-            // Check layers constraint - count existing layers plus the new one
-            if (existing_item.get().getStuffingLayers() > 0) {
-                std::map<long, bool> distinct_layers;
-                
-                // Count existing layers
-                for (const auto& other_item : bin.getItems()) {
-                    if (&other_item.get() == &existing_item.get() || 
-                        &other_item.get() == &new_item) {
-                        continue;
-                    }
-                    
-                    // Check if directly above with significant overlap
-                    if (isItemDirectlyAbove(existing_item.get(), other_item.get(), overlap_threshold)) {
-                        distinct_layers[std::get<1>(other_item.get().getPosition())] = true;
-                    }
-                }
-                
-                // Add the new item's layer
-                distinct_layers[std::get<1>(new_position)] = true;
-                
-                // Apply constraint based on constraint type
-                if (existing_item.get().getHeightConstraintType() == HeightConstraintType::EXACT) {
-                    if (static_cast<int>(distinct_layers.size()) != existing_item.get().getStuffingLayers()) {
-                        return true; // Violates layers constraint - need exactly the specified number
-                    }
-                } else {
-                    // For MAXIMUM type, don't exceed the specified layers
-                    if (static_cast<int>(distinct_layers.size()) > existing_item.get().getStuffingLayers()) {
-                        return true; // Violates constraint - too many layers
-                    }
-                }
-            }
-            
-            // Check weight constraint
-            if (existing_item.get().getStuffingMaxWeight() > 0) {
-                float total_weight = 0.0f;
-                
-                // Sum weights of items above
-                for (const auto& other_item : bin.getItems()) {
-                    if (&other_item.get() == &existing_item.get() || 
-                        &other_item.get() == &new_item) {
-                        continue;
-                    }
-                    
-                    // Check if directly above
-                    if (isItemDirectlyAbove(existing_item.get(), other_item.get(), overlap_threshold)) {
-                        total_weight += other_item.get().weight;
-                    }
-                }
-                
-                // Add new item's weight
-                total_weight += new_item.weight;
-                
-                if (total_weight > existing_item.get().getStuffingMaxWeight()) {
-                    return true; // Exceeds weight constraint
+        // Check layers constraint - the new item's layer is already counted
+        if (existing_item.getStuffingLayers() > 0) {
+            int layer_count = static_cast<int>(support.layersAbove(edge.index));
+            if (existing_item.getHeightConstraintType() == HeightConstraintType::EXACT) {
+                if (layer_count != existing_item.getStuffingLayers()) {
+                    return true; // Violates layers constraint - need exactly the specified number
                 }
+            } else if (layer_count > existing_item.getStuffingLayers()) {
+                // For MAXIMUM type, don't exceed the specified layers
+                return true;
             }
         }
+        
+        // Check weight constraint, new item included
+        if (existing_item.getStuffingMaxWeight() > 0 &&
+            support.loadAbove(edge.index) > existing_item.getStuffingMaxWeight()) {
+            return true; // Exceeds weight constraint
+        }
     }
     
     return false;
 }
 
+const BinIndex& Packer::getBinIndex() {
+    if (!bin_index.matches(bins)) {
+        bin_index.build(bins);
+    }
+    return bin_index;
+}
+
+bool Packer::canStandAlone(const Item& item) {
+    // With nothing above it, an item only fails checkStuffingConstraints when
+    // it needs an exact stuffing height or an exact number of layers on top
+    return item.getHeightConstraintType() != HeightConstraintType::EXACT ||
+           (item.getStuffingHeight() <= 0 && item.getStuffingLayers() <= 0);
+}
+
 std::optional<std::reference_wrapper<Bin>> Packer::findFittedBin(Item& item) {
-    // Try to fit item in smallest bins first for better packing efficiency
-    for (auto& bin : bins) {
-        if (!bin.putItem(item, START_POSITION)) {
-            continue;
+    // Try to fit item in smallest bins first for better packing efficiency.
+    // Only bins big enough for the item are looked at, and the item is never
+    // left in the bin: an empty bin is probed, a used one tried and undone.
+    const bool stands_alone = canStandAlone(item);
+    std::optional<std::reference_wrapper<Bin>> found;
+    getBinIndex().forEachCandidate(item.getVolume(), false, sortedDimensions(item), [&](std::size_t position) {
+        Bin& bin = bins[position];
+        if (!bin.probe(item)) {
+            return false;
         }
-        
-        // Verify stuffing constraints
-        if (!checkStuffingConstraints(bin, item, START_POSITION) || 
-            wouldViolateExistingItemConstraints(bin, item, START_POSITION)) {
-            // Remove the item if constraints aren't satisfied
-            if (bin.getItems().size() == 1 && &bin.getItems()[0].get() == &item) {
-                bin.setItems({});
+
+        if (bin.getItems().empty()) {
+            if (!stands_alone) {
+                return false;
             }
-            continue;
+            // Leave the item posed as putItem would have
+            item.setPosition({std::get<0>(START_POSITION), std::get<1>(START_POSITION), std::get<2>(START_POSITION)});
+            item.setRotationType(bin.getBestRotationOrder(item, START_POSITION));
+            found = std::ref(bin);
+            return true;
         }
-        
-        if (bin.getItems().size() == 1 && &bin.getItems()[0].get() == &item) {
-            bin.setItems({});
+
+        // A bin that already holds items can still take this one if the
+        // origin is free, so try it there and take the item out again
+        const std::size_t mark = bin.checkpoint();
+        if (!bin.putItem(item, START_POSITION)) {
+            return false;
         }
-        return std::ref(bin);
-    }
-    return std::nullopt;
+        const bool fits = checkStuffingConstraints(bin, item, START_POSITION) &&
+                          !wouldViolateExistingItemConstraints(bin, item);
+        bin.rollback(mark);
+        if (fits) {
+            found = std::ref(bin);
+        }
+        return fits;
+    });
+    return found;
 }
 
 std::optional<std::reference_wrapper<Bin>> Packer::getBiggerBinThan(const Bin& other_bin) {
-    auto it = std::find_if(bins.begin(), bins.end(), [&other_bin](Bin& bin) {
-        return bin.getVolume() > other_bin.getVolume();
+    std::optional<std::reference_wrapper<Bin>> found;
+    getBinIndex().forEachCandidate(other_bin.getVolume(), true, {0, 0, 0}, [&](std::size_t position) {
+        found = std::ref(bins[position]);
+        return true;
     });
-    if (it != bins.end()) {
-        return std::ref(*it);
-    }
-    return std::nullopt;
+    return found;
+}
+
+std::optional<std::reference_wrapper<Bin>> Packer::getBiggerBinThan(const Bin& other_bin, const Item& item) {
+    std::optional<std::reference_wrapper<Bin>> found;
+    long min_volume = std::max(other_bin.getVolume(), item.getVolume() - 1);
+    getBinIndex().forEachCandidate(min_volume, true, sortedDimensions(item), [&](std::size_t position) {
+        if (bins[position].probe(item)) {
+            found = std::ref(bins[position]);
+        }
+        return found.has_value();
+    });
+    return found;
 }
 
 void Packer::unfitItem(std::vector<Item*>& item_ptrs) {
@@ -390,238 +523,925 @@ void Packer::unfitItem(std::vector<Item*>& item_ptrs) {
     }
 }
 
-std::vector<Item*> Packer::packToBin(Bin& bin, std::vector<Item*>& item_ptrs) {
-    // Start timing
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    std::vector<Item*> unpacked;
-    std::optional<std::reference_wrapper<Bin>> b2;
-    
-    // Try to place the first item
-    if (!bin.putItem(*item_ptrs[0], START_POSITION) || 
-        !checkStuffingConstraints(bin, *item_ptrs[0], START_POSITION) ||
-        wouldViolateExistingItemConstraints(bin, *item_ptrs[0], START_POSITION)) {
-        // If first item doesn't fit, try a bigger bin
-        b2 = getBiggerBinThan(bin);
-        if (b2) {
-            return packToBin(b2->get(), item_ptrs);
-        }
-        return {item_ptrs.begin(), item_ptrs.end()};
+bool Packer::placeAtCandidates(Bin& bin, Item& item, bool online) {
+    if (options.placement == PlacementModel::MAXIMAL_SPACES) {
+        return placeInMaximalSpace(bin, item);
+    }
+    if (options.best_fit && !online) {
+        return placeBestFit(bin, item);
     }
-    
-    // Optimization: Pre-calculate potential placement positions
-    // This avoids redundant calculations in the inner loops
-    struct PlacementPosition {
-        std::tuple<long, long, long> position;
-        Axis axis;
-        std::reference_wrapper<Item> relative_to;
-    };
 
-    // For remaining items, try to place them efficiently
-    for (size_t i = 1; i < item_ptrs.size(); ++i) {
-        auto current_time = std::chrono::high_resolution_clock::now();
-        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            current_time - start_time).count();
-            
-        // Check time limit
-        if (elapsed_ms > MAX_PACK_TIME_MS / 2) {  // Half the total time budget
-            // Add remaining to unpacked
-            unpacked.insert(unpacked.end(), item_ptrs.begin() + i, item_ptrs.end());
-            break;
-        }
-    
-        bool fitted = false;
-        std::vector<PlacementPosition> positions;
-        
-        // Generate potential positions based on existing items
-        for (const auto& item_b : bin.getItems()) {
-            for (const auto& axis : {Axis::height, Axis::depth, Axis::width}) {
-                std::tuple<long, long, long> item_position;
-                
-                // Calculate position based on current axis
-                if (axis == Axis::width) {
-                    item_position = {
-                        std::get<0>(item_b.get().getPosition()) + item_b.get().getDimension()[0],
-                        std::get<1>(item_b.get().getPosition()),
-                        std::get<2>(item_b.get().getPosition())
-                    };
-                } else if (axis == Axis::depth) {
-                    item_position = {
-                        std::get<0>(item_b.get().getPosition()),
-                        std::get<1>(item_b.get().getPosition()),
-                        std::get<2>(item_b.get().getPosition()) + item_b.get().getDimension()[2]
-                    };
-                } else {
-                    item_position = {
-                        std::get<0>(item_b.get().getPosition()),
-                        std::get<1>(item_b.get().getPosition()) + item_b.get().getDimension()[1],
-                        std::get<2>(item_b.get().getPosition())
-                    };
-                }
-                
-                positions.push_back({item_position, axis, item_b});
-            }
-        }
-        
-        // Sort positions by potential for efficient packing
-        // This helps place items more compactly
-        std::sort(positions.begin(), positions.end(), 
-            [&bin](const PlacementPosition& a, const PlacementPosition& b) {
-                // Prioritize positions closer to origin
-                long a_dist = std::get<0>(a.position) + std::get<1>(a.position) + std::get<2>(a.position);
-                long b_dist = std::get<0>(b.position) + std::get<1>(b.position) + std::get<2>(b.position);
-                return a_dist < b_dist;
-            });
-        
-        // Try each position
-        for (const auto& pos : positions) {
-            if (fitted) break;
-            
-            // Quickly check position constraints
-            auto item_dim = item_ptrs[i]->getDimension();
-            
+    // putItem turns the item to the bin's best rotation for it, the same at
+    // every position, so candidates are bounds-checked for that one only
+    const RotationType rotation = bin.getBestRotationOrder(item, START_POSITION);
+    const std::array<long, 3> rotated_dims = rotateDimension(item.getWidth(), item.getHeight(),
+                                                             item.getDepth(), rotation);
+    const std::array<long, 3> extent = {bin.getWidth(), bin.getHeight(), bin.getDepth()};
+
+    std::array<std::array<long, 3>, CANDIDATE_BATCH> batch;
+    std::array<uint8_t, CANDIDATE_BATCH> fit_masks;
+    std::size_t batch_size = 0;
+    passed_over.clear();
+
+    auto tryBatch = [&]() {
+        // Bounds-check the whole batch in one pass
+        boundsFitMasks(batch.data(), batch_size, &rotated_dims, 1, extent, fit_masks.data());
+
+        std::size_t count = batch_size;
+        batch_size = 0;
+        for (std::size_t j = 0; j < count; ++j) {
             // Skip if exceeds bin dimensions
-            if (std::get<0>(pos.position) + item_dim[0] > bin.getWidth() ||
-                std::get<1>(pos.position) + item_dim[1] > bin.getHeight() ||
-                std::get<2>(pos.position) + item_dim[2] > bin.getDepth()) {
+            if (fit_masks[j] == 0) {
                 continue;
             }
             
             // Skip if weight limit would be exceeded
-            float total_weight = 0.0f;
-            for (const auto& existing_item : bin.getItems()) {
-                total_weight += existing_item.get().weight;
-            }
-            if (bin.max_weight > 0 && total_weight + item_ptrs[i]->weight > bin.max_weight) {
+            if (bin.max_weight > 0 && bin.getTotalWeight() + item.weight > bin.max_weight) {
                 continue;
             }
             
+            // Let the item down onto whatever is below the point, and skip
+            // it if it would not stand on enough of the load there. The
+            // overlap test goes first as it rules out far more positions.
+            if (options.min_support > 0) {
+                const ItemGeometry pose = item.getGeometry(rotation, {batch[j][0], batch[j][1], batch[j][2]});
+                if (bin.intersectsPlacedItem(pose)) {
+                    continue;
+                }
+                const long rest = bin.getHeightMap(options.support_cell).restingHeight(
+                    batch[j][0], batch[j][2], pose.dimension[0], pose.dimension[2]);
+                batch[j][1] = std::min(batch[j][1], rest);
+                if (!isSupported(bin, item.getGeometry(pose.rotation, {batch[j][0], batch[j][1], batch[j][2]}))) {
+                    continue;
+                }
+            }
+
             // Try to place item at this position
-            if (bin.putItem(*item_ptrs[i], pos.position)) {
+            const std::tuple<long, long, long> position = {batch[j][0], batch[j][1], batch[j][2]};
+            std::size_t mark = bin.checkpoint();
+            if (bin.putItem(item, position)) {
                 // Verify constraints
-                if (!checkStuffingConstraints(bin, *item_ptrs[i], pos.position) ||
-                    wouldViolateExistingItemConstraints(bin, *item_ptrs[i], pos.position)) {
-                    bin.removeItem(*item_ptrs[i]);
+                if (!checkStuffingConstraints(bin, item, position) ||
+                    wouldViolateExistingItemConstraints(bin, item)) {
+                    bin.rollback(mark);
                 } else {
-                    fitted = true;
-                    break;
+                    return true;
                 }
             }
         }
-        
-        // If item couldn't be placed, try next bigger bin or mark as unfit
-        if (!fitted) {
-            b2 = getBiggerBinThan(bin);
-            if (b2) {
-                // Create a named vector instead of a temporary one
-                std::vector<Item*> remaining_items(item_ptrs.begin() + i, item_ptrs.end());
-                auto left = packToBin(b2->get(), remaining_items);
-                if (left.empty()) {
-                    // Successfully placed in bigger bin
-                    break;
-                }
+        return false;
+    };
+
+    // Try the bin's extreme points, closest to the origin first, a batch at
+    // a time. Trial puts are undone before the next candidate, so the
+    // candidates collected ahead stay valid.
+    // In online mode the walk skips points already blocked for an item this
+    // thick, and gives up after the candidate budget
+    const long shortest_edge = online
+        ? std::min({item.getWidth(), item.getHeight(), item.getDepth()}) : 0;
+    std::size_t visited = 0;
+    bool out_of_budget = false;
+    bool fitted = bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& position) {
+        if (online) {
+            if (options.online_candidates > 0 && visited++ == options.online_candidates) {
+                out_of_budget = true;
+                return true;
             }
-            unpacked.push_back(item_ptrs[i]);
+            passed_over.push_back(position);
         }
+        batch[batch_size++] = {std::get<0>(position), std::get<1>(position), std::get<2>(position)};
+        return batch_size == CANDIDATE_BATCH && tryBatch();
+    }, shortest_edge);
+    if (out_of_budget) {
+        fitted = false;
+    }
+    if (!fitted && batch_size > 0) {
+        fitted = tryBatch();
     }
-    
-    return unpacked;
-}
 
-void Packer::pack() {
-    // Start timing
-    auto start_time = std::chrono::high_resolution_clock::now();
+    // Online placements are never taken back, so a cube that does not fit
+    // at a point never will: block the point for items at least as thick as
+    // this one. A thinner arrival may still fit there, so a point is only
+    // retired once it lies inside a placed box
+    auto cubeFits = [&](const std::tuple<long, long, long>& position, long edge) {
+        const ItemGeometry cube{{edge, edge, edge},
+                                {std::get<0>(position), std::get<1>(position), std::get<2>(position)},
+                                RotationType::whd, 0.0f};
+        return std::get<0>(position) + edge <= extent[0] && std::get<1>(position) + edge <= extent[1] &&
+               std::get<2>(position) + edge <= extent[2] && !bin.intersectsPlacedItem(cube);
+    };
+    for (const auto& position : passed_over) {
+        if (cubeFits(position, shortest_edge)) {
+            continue;
+        }
+        if (!cubeFits(position, 1)) {
+            bin.retireCandidate(position);
+        } else {
+            bin.blockCandidate(position, shortest_edge);
+        }
+    }
+    return fitted;
+}
 
-    // Sort bins by volume (smallest to largest)
-    std::sort(bins.begin(), bins.end(), [](const Bin& a, const Bin& b) {
-        return a.getVolume() < b.getVolume();
-    });
-    
-    // Sort items by volume (largest to smallest) for better packing
-    // And prioritize items with constraints
-    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
-        // Give highest priority to items with layer constraints
-        bool a_has_layer_constraint = a.getStuffingLayers() > 0;
-        bool b_has_layer_constraint = b.getStuffingLayers() > 0;
-        
-        if (a_has_layer_constraint && !b_has_layer_constraint)
-            return true;
-        if (!a_has_layer_constraint && b_has_layer_constraint)
-            return false;
-            
-        // Then prioritize other constraints
-        bool a_has_other_constraints = a.getStuffingMaxWeight() > 0 || 
-                                     a.getStuffingHeight() > 0 ||
-                                     a.isHeightConstrained();
-                                     
-        bool b_has_other_constraints = b.getStuffingMaxWeight() > 0 || 
-                                     b.getStuffingHeight() > 0 ||
-                                     b.isHeightConstrained();
-        
-        // If one has constraints and the other doesn't, prioritize the constrained one
-        if (a_has_other_constraints && !b_has_other_constraints)
-            return true;
-        if (!a_has_other_constraints && b_has_other_constraints)
-            return false;
-        
-        // Otherwise sort by volume as before
-        return a.getVolume() > b.getVolume();
-    });
+// Best-fit score of a pose: its far corner, height weighing most, then depth
+static long farCornerScore(const std::array<long, 3>& position, const std::array<long, 3>& dimension) {
+    return 4 * (position[1] + dimension[1]) + 2 * (position[2] + dimension[2]) + (position[0] + dimension[0]);
+}
 
-    // Group similar items together to optimize placement decisions
-    std::unordered_map<std::string, std::vector<Item*>> item_groups;
-    std::vector<Item*> item_ptrs;
-    for (auto& itm : items) {
-        item_ptrs.push_back(&itm);
-        
-        // Create a unique key based on dimensions (ignoring position)
-        std::string dim_key = std::to_string(itm.getWidth()) + "x" + 
-                             std::to_string(itm.getHeight()) + "x" + 
-                             std::to_string(itm.getDepth());
-        item_groups[dim_key].push_back(&itm);
+bool Packer::placeBestFit(Bin& bin, Item& item) {
+    if (bin.max_weight > 0 && bin.getTotalWeight() + item.weight > bin.max_weight) {
+        return false;
     }
+    const OrientationTable& table = bin.getOrientations(item);
+    const std::array<long, 3> extent = {bin.getWidth(), bin.getHeight(), bin.getDepth()};
 
-    // Process items in batches for better efficiency
-    std::vector<Item*> remaining_items = item_ptrs;
-    std::vector<Item*> batch_items;
+    // The least any orientation adds to a position's score
+    long least_added = std::numeric_limits<long>::max();
+    for (const Orientation& orientation : table) {
+        if ((table.fitting >> static_cast<int>(orientation.rotation)) & 1) {
+            least_added = std::min(least_added, farCornerScore({0, 0, 0}, orientation.dimension));
+        }
+    }
+    if (least_added == std::numeric_limits<long>::max()) {
+        return false;
+    }
 
-    while (!remaining_items.empty()) {
-        auto current_time = std::chrono::high_resolution_clock::now();
-        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            current_time - start_time).count();
-            
-        // Check time limit
-        if (elapsed_ms > MAX_PACK_TIME_MS) {
-            // Just stop and return the best solution so far
-            break;
+    long best_score = std::numeric_limits<long>::max();
+    std::array<long, 3> best_position{};
+    RotationType best_rotation = RotationType::whd;
+    // With a support minimum poses are let down onto the load, as the
+    // first-fit walk does, so a candidate's own height bounds nothing: the
+    // walk and each pose are only cut short on the lowered position
+    const bool lowered = options.min_support > 0;
+    bin.forEachCandidatePosition([&](const std::tuple<long, long, long>& candidate) {
+        const std::array<long, 3> anchor = {std::get<0>(candidate), std::get<1>(candidate), std::get<2>(candidate)};
+        // Every later candidate is at least this far from the origin, and a
+        // score weighs each coordinate at least once
+        if (!lowered && anchor[0] + anchor[1] + anchor[2] + least_added >= best_score) {
+            return true;
         }
-        
-        // Take the next item (largest volume first)
-        Item* current_item = remaining_items[0];
-        batch_items.clear();
-        batch_items.push_back(current_item);
-        
-        // Find similar items and group them
-        std::string dim_key = std::to_string(current_item->getWidth()) + "x" + 
-                            std::to_string(current_item->getHeight()) + "x" + 
-                            std::to_string(current_item->getDepth());
-        
-        // Add similar items to this batch
-        for (size_t i = 1; i < remaining_items.size() && batch_items.size() < 100; ++i) {
-            std::string item_key = std::to_string(remaining_items[i]->getWidth()) + "x" + 
-                                  std::to_string(remaining_items[i]->getHeight()) + "x" + 
-                                  std::to_string(remaining_items[i]->getDepth());
-                                  
-            if (item_key == dim_key) {
-                batch_items.push_back(remaining_items[i]);
+        if (!lowered && farCornerScore(anchor, {0, 0, 0}) + least_added >= best_score) {
+            return false;
+        }
+        for (const Orientation& orientation : table) {
+            if (!((table.fitting >> static_cast<int>(orientation.rotation)) & 1)) {
+                continue;
+            }
+            std::array<long, 3> position = anchor;
+            const auto& d = orientation.dimension;
+            if (position[0] + d[0] > extent[0] || position[1] + d[1] > extent[1] || position[2] + d[2] > extent[2]) {
+                continue;
+            }
+            if (lowered) {
+                position[1] = std::min(position[1], bin.getHeightMap(options.support_cell).restingHeight(
+                    position[0], position[2], d[0], d[2]));
+            }
+            // Cheap tests first: only a pose that would beat the best gets an overlap test
+            if (farCornerScore(position, d) >= best_score) {
+                continue;
+            }
+            const ItemGeometry pose = item.getGeometry(orientation.rotation, {position[0], position[1], position[2]});
+            if (bin.intersectsPlacedItem(pose) || (lowered && !isSupported(bin, pose))) {
+                continue;
+            }
+            const std::tuple<long, long, long> at = {position[0], position[1], position[2]};
+            item.setRotationType(orientation.rotation);
+            item.setPosition(at);
+            std::size_t mark = bin.checkpoint();
+            bin.addItem(item);
+            const bool allowed = checkStuffingConstraints(bin, item, at) && !wouldViolateExistingItemConstraints(bin, item);
+            bin.rollback(mark);
+            if (allowed) {
+                best_score = farCornerScore(position, d);
+                best_position = position;
+                best_rotation = orientation.rotation;
+            }
+        }
+        return false;
+    });
+    if (best_score == std::numeric_limits<long>::max()) {
+        return false;
+    }
+    item.setRotationType(best_rotation);
+    item.setPosition({best_position[0], best_position[1], best_position[2]});
+    bin.addItem(item);
+    return true;
+}
+
+bool Packer::placeItem(Bin& bin, Item& item, bool best_fit) {
+    return best_fit ? placeBestFit(bin, item) : placeAtCandidates(bin, item);
+}
+
+bool Packer::isSupported(const Bin& bin, const ItemGeometry& geometry) const {
+    const auto& p = geometry.position;
+    const auto& d = geometry.dimension;
+    if (p[1] == 0) {
+        return true;
+    }
+    return bin.getHeightMap(options.support_cell).supportedFraction(p[0], p[1], p[2], d[0], d[2]) >= options.min_support;
+}
+
+bool Packer::placeInMaximalSpace(Bin& bin, Item& item) {
+    if (bin.max_weight > 0 && bin.getTotalWeight() + item.weight > bin.max_weight) {
+        return false;
+    }
+    const MaximalSpaceSet& spaces = bin.getFreeSpaces();
+    const OrientationTable& table = bin.getOrientations(item);
+
+    // Anchor before score, so the load grows from the origin as it does on
+    // extreme points; `table` lists orientations best first on equal scores
+    auto better = [](const std::pair<std::array<long, 3>, const Orientation*>& a,
+                     const std::pair<std::array<long, 3>, const Orientation*>& b) {
+        if (a.first != b.first) {
+            return MaximalSpaceSet::nearer(a.first, b.first);
+        }
+        return a.second->score > b.second->score;
+    };
+    auto tryChoice = [&](const std::array<long, 3>& anchor, const Orientation& orientation) {
+        const std::tuple<long, long, long> position = {anchor[0], anchor[1], anchor[2]};
+        if (options.min_support > 0 && !isSupported(bin, item.getGeometry(orientation.rotation, position))) {
+            return false;
+        }
+        item.setRotationType(orientation.rotation);
+        item.setPosition(position);
+        std::size_t mark = bin.checkpoint();
+        bin.addItem(item);
+        if (checkStuffingConstraints(bin, item, position) && !wouldViolateExistingItemConstraints(bin, item)) {
+            return true;
+        }
+        bin.rollback(mark);
+        return false;
+    };
+
+    // The nearest space for each orientation settles it unless constraints
+    // get in the way
+    std::optional<std::pair<std::array<long, 3>, const Orientation*>> first;
+    for (const Orientation& orientation : table) {
+        if (!((table.fitting >> static_cast<int>(orientation.rotation)) & 1)) {
+            continue;
+        }
+        if (std::optional<GridBox> space = spaces.best(orientation.dimension)) {
+            std::pair<std::array<long, 3>, const Orientation*> choice{space->min, &orientation};
+            if (!first || better(choice, *first)) {
+                first = choice;
+            }
+        }
+    }
+    if (!first) {
+        return false;
+    }
+    if (tryChoice(first->first, *first->second)) {
+        return true;
+    }
+
+    // Otherwise every space and orientation in turn. The set is not touched
+    // while trying, as trial puts are undone before it syncs again.
+    space_choices.clear();
+    for (const Orientation& orientation : table) {
+        if (!((table.fitting >> static_cast<int>(orientation.rotation)) & 1)) {
+            continue;
+        }
+        spaces.forEachFitting(orientation.dimension, [&](const GridBox& space) {
+            space_choices.push_back({space.min, &orientation});
+        });
+    }
+    std::sort(space_choices.begin(), space_choices.end(), better);
+    for (const auto& choice : space_choices) {
+        if (tryChoice(choice.first, *choice.second)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<Item*> Packer::packToBin(Bin& bin, std::vector<Item*>& item_ptrs) {
+    std::vector<Item*> unpacked;
+    std::optional<std::reference_wrapper<Bin>> b2;
+    
+    // Try to place the first item; best fit picks its orientation too
+    bool first_fitted = options.best_fit
+        ? placeBestFit(bin, *item_ptrs[0])
+        : bin.putItem(*item_ptrs[0], START_POSITION) &&
+          checkStuffingConstraints(bin, *item_ptrs[0], START_POSITION) &&
+          !wouldViolateExistingItemConstraints(bin, *item_ptrs[0]);
+    if (!first_fitted) {
+        // If first item doesn't fit, try a bigger bin
+        b2 = getBiggerBinThan(bin, *item_ptrs[0]);
+        if (b2) {
+            return packToBin(b2->get(), item_ptrs);
+        }
+        return {item_ptrs.begin(), item_ptrs.end()};
+    }
+    
+    // For remaining items, try to place them efficiently
+    for (size_t i = 1; i < item_ptrs.size(); ++i) {
+        // Check time limit and cancellation
+        if (shouldStop()) {
+            // Add remaining to unpacked
+            unpacked.insert(unpacked.end(), item_ptrs.begin() + i, item_ptrs.end());
+            break;
+        }
+    
+        bool fitted = placeAtCandidates(bin, *item_ptrs[i]);
+
+        // If item couldn't be placed, try next bigger bin or mark as unfit
+        if (!fitted) {
+            b2 = getBiggerBinThan(bin, *item_ptrs[i]);
+            if (b2) {
+                // The bigger bin takes over the rest; whatever it leaves is
+                // handed back as is, as it may already have placed the others
+                std::vector<Item*> remaining_items(item_ptrs.begin() + i, item_ptrs.end());
+                auto left = packToBin(b2->get(), remaining_items);
+                unpacked.insert(unpacked.end(), left.begin(), left.end());
+                break;
+            }
+            unpacked.push_back(item_ptrs[i]);
+        }
+    }
+    
+    return unpacked;
+}
+
+// A float in as many digits as it takes to read it back unchanged
+static std::string exactString(float value) {
+    std::ostringstream out;
+    out << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+    return out.str();
+}
+
+// Every PackOptions field that changes where pack() puts items, for the
+// result cache key. A new option of that kind must be added here.
+static std::string placementSettings(const PackOptions& options) {
+    return "strategy=" + std::to_string(static_cast<int>(options.strategy)) +
+           ",identical=" + std::to_string(options.identical_fast_path) +
+           ",placement=" + std::to_string(static_cast<int>(options.placement)) +
+           ",best_fit=" + std::to_string(options.best_fit) +
+           ",min_support=" + exactString(options.min_support) +
+           ",support_cell=" + std::to_string(options.support_cell);
+}
+
+// Constrained items are packed first whatever the order: 0 for layer
+// constraints, 1 for other stuffing or height constraints, 2 for the rest
+static int constraintRank(const Item& item) {
+    if (item.getStuffingLayers() > 0) {
+        return 0;
+    }
+    if (item.getStuffingMaxWeight() > 0 || item.getStuffingHeight() > 0 || item.isHeightConstrained()) {
+        return 1;
+    }
+    return 2;
+}
+
+// Ranking key of an item under one of the non-default orders; larger goes first
+static double orderKey(const Item& item, ItemOrder order) {
+    switch (order) {
+        case ItemOrder::LONGEST_EDGE:
+            return static_cast<double>(std::max({item.getWidth(), item.getHeight(), item.getDepth()}));
+        case ItemOrder::BASE_AREA:
+            return static_cast<double>(item.getWidth()) * item.getDepth();
+        case ItemOrder::WEIGHT:
+            return item.weight;
+        default:
+            return 0;
+    }
+}
+
+// Items a wall or pallet pattern may hold. Stuffing, height, floor and
+// stacking rules are left to the item-by-item search.
+static bool fitsInWall(const Item& item) {
+    return constraintRank(item) == 2 && !item.isBottomLoadOnlyEnabled() && !item.isDisableStackingEnabled();
+}
+
+static uint8_t allowedMask(const Item& item) {
+    uint8_t allowed = 0;
+    for (auto rotation : item.getAllowedRotations()) {
+        allowed |= uint8_t(1u << static_cast<int>(rotation));
+    }
+    return allowed;
+}
+
+// Items with equal keys are interchangeable in a wall or a pallet
+static std::tuple<long, long, long, uint8_t, float> shapeKey(const Item& item) {
+    return {item.getWidth(), item.getHeight(), item.getDepth(), allowedMask(item), item.weight};
+}
+
+// Whether the items are two or more copies of one unconstrained box
+static bool allIdentical(const std::vector<Item*>& items) {
+    if (items.size() < 2 || !fitsInWall(*items[0])) {
+        return false;
+    }
+    const auto key = shapeKey(*items[0]);
+    return std::all_of(items.begin(), items.end(), [&key](const Item* item) {
+        return fitsInWall(*item) && shapeKey(*item) == key;
+    });
+}
+
+void Packer::packIdentical(std::vector<Item*>& remaining) {
+    const Item& sample = *remaining[0];
+    PalletKey key{{sample.getWidth(), sample.getHeight(), sample.getDepth()}, allowedMask(sample), sample.weight, {0, 0, 0}, 0};
+
+    std::size_t next = 0;
+    for (auto& bin : bins) {
+        if (next == remaining.size() || shouldStop()) {
+            break;
+        }
+        if (!bin.getItems().empty()) {
+            // Patterns start from an empty floor
+            continue;
+        }
+
+        key.bin = {bin.getWidth(), bin.getHeight(), bin.getDepth()};
+        key.bin_max_weight = bin.max_weight;
+        const PalletPattern pattern = options.pallet_patterns ? options.pallet_patterns->lookup(key) : solvePalletPattern(key);
+
+        // Layer by layer from the floor; the cells need no collision checks
+        const std::size_t count = std::min(pattern.capacity, remaining.size() - next);
+        for (std::size_t k = 0; k < count; ++k) {
+            const FaceCell& cell = pattern.cells[k % pattern.cells.size()];
+            const long y = static_cast<long>(k / pattern.cells.size()) * pattern.layer_height;
+            Item& item = *remaining[next + k];
+            item.setRotationType(cell.turned ? pattern.turned : pattern.rotation);
+            item.setPosition({cell.x, y, cell.y});
+            bin.addItem(item);
+        }
+        next += count;
+        reportProgress();
+    }
+    remaining.erase(remaining.begin(), remaining.begin() + next);
+}
+
+long Packer::placeWall(Bin& bin, long front, std::vector<Item*>& remaining, FacePatternCache& patterns) {
+    const long room = bin.getDepth() - front;
+    const long face_area = bin.getWidth() * bin.getHeight();
+
+    // Items of one size, rotations and weight are interchangeable in a wall;
+    // members are positions in `remaining`, in packing order
+    struct Group {
+        const Item* sample;
+        std::vector<std::size_t> members;
+    };
+    std::vector<Group> groups;
+    std::map<std::tuple<long, long, long, uint8_t, float>, std::size_t> group_of;
+    for (std::size_t i = 0; i < remaining.size(); ++i) {
+        const Item& item = *remaining[i];
+        if (!fitsInWall(item)) {
+            continue;
+        }
+        auto [it, inserted] = group_of.emplace(shapeKey(item), groups.size());
+        if (inserted) {
+            groups.push_back({&item, {}});
+        }
+        groups[it->second].members.push_back(i);
+    }
+
+    // Walls follow the packing order: the first group that can fill a layer
+    // well enough sets it, standing the way that fills the slab best
+    double best_fill = MIN_WALL_FILL;
+    const Group* best_group = nullptr;
+    const std::vector<FaceCell>* best_cells = nullptr;
+    std::size_t best_count = 0;
+    long best_depth = 0;
+    RotationType best_rotation = RotationType::whd;
+    RotationType best_turned = RotationType::whd;
+    for (const auto& group : groups) {
+        const Item& sample = *group.sample;
+        for (auto rotation : sample.getAllowedRotations()) {
+            const auto dim = rotateDimension(sample.getWidth(), sample.getHeight(), sample.getDepth(), rotation);
+            if (dim[0] > bin.getWidth() || dim[1] > bin.getHeight() || dim[2] > room) {
+                continue;
+            }
+
+            // The same item turned a quarter on the face, if it may stand that way
+            std::optional<RotationType> turned;
+            for (auto other : sample.getAllowedRotations()) {
+                if (dim[0] != dim[1] && rotateDimension(sample.getWidth(), sample.getHeight(), sample.getDepth(), other) ==
+                                            std::array<long, 3>{dim[1], dim[0], dim[2]}) {
+                    turned = other;
+                    break;
+                }
+            }
+
+            const auto& cells = patterns.lookup(bin.getWidth(), bin.getHeight(), dim[0], dim[1], turned.has_value());
+            std::size_t count = std::min(cells.size(), group.members.size());
+            if (bin.max_weight > 0 && sample.weight > 0) {
+                float capacity = (bin.max_weight - bin.getTotalWeight()) / sample.weight;
+                count = std::min(count, static_cast<std::size_t>(std::max(capacity, 0.0f)));
+            }
+            double fill = static_cast<double>(count) * sample.getVolume() / (static_cast<double>(face_area) * dim[2]);
+            if (count > 0 && fill > best_fill) {
+                best_fill = fill;
+                best_group = &group;
+                best_cells = &cells;
+                best_count = count;
+                best_depth = dim[2];
+                best_rotation = rotation;
+                best_turned = turned.value_or(rotation);
+            }
+        }
+        if (best_group) {
+            break;
+        }
+    }
+    if (!best_group) {
+        return 0;
+    }
+
+    // The slab past `front` is empty, so the cells go in without collision checks
+    std::vector<bool> placed(remaining.size(), false);
+    for (std::size_t k = 0; k < best_count; ++k) {
+        const FaceCell& cell = (*best_cells)[k];
+        Item& item = *remaining[best_group->members[k]];
+        item.setRotationType(cell.turned ? best_turned : best_rotation);
+        item.setPosition({cell.x, cell.y, front});
+        bin.addItem(item);
+        placed[best_group->members[k]] = true;
+    }
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < remaining.size(); ++i) {
+        if (!placed[i]) {
+            remaining[kept++] = remaining[i];
+        }
+    }
+    remaining.resize(kept);
+    return best_depth;
+}
+
+void Packer::packWalls(std::vector<Item*>& remaining) {
+    FacePatternCache patterns;
+    for (auto& bin : bins) {
+        if (remaining.empty() || shouldStop()) {
+            break;
+        }
+
+        long front = bin.getMaxOccupied()[2];
+        bool walled = false;
+        while (!shouldStop()) {
+            long depth = placeWall(bin, front, remaining, patterns);
+            if (depth == 0) {
+                break;
+            }
+            front += depth;
+            walled = true;
+            reportProgress();
+        }
+        if (!walled) {
+            // Nothing fills a layer here; leave the bin to the item-by-item pass
+            continue;
+        }
+
+        // Fill the space the walls left, largest items first
+        std::vector<Item*> left;
+        for (Item* item : remaining) {
+            if (shouldStop() || !placeAtCandidates(bin, *item)) {
+                left.push_back(item);
+            }
+        }
+        remaining.swap(left);
+        reportProgress();
+    }
+}
+
+bool Packer::replayResult(const OrderSignature& signature, const CachedResult& result) {
+    for (const auto& placement : result.placements) {
+        if (placement.item >= items.size() || placement.bin >= bins.size()) {
+            return false;
+        }
+    }
+    for (uint32_t item : result.unfit) {
+        if (item >= items.size()) {
+            return false;
+        }
+    }
+
+    for (const auto& placement : result.placements) {
+        Item& item = items[signature.item_ranks[placement.item]];
+        item.setRotationType(placement.rotation);
+        item.setPosition({placement.position[0], placement.position[1], placement.position[2]});
+        bins[signature.bin_ranks[placement.bin]].addItem(item);
+    }
+    for (uint32_t item : result.unfit) {
+        unfit_items.push_back(items[signature.item_ranks[item]]);
+    }
+    return true;
+}
+
+CachedResult Packer::recordResult(const OrderSignature& signature) const {
+    std::vector<uint32_t> item_canonical(items.size());
+    for (std::size_t k = 0; k < signature.item_ranks.size(); ++k) {
+        item_canonical[signature.item_ranks[k]] = static_cast<uint32_t>(k);
+    }
+    std::vector<uint32_t> bin_canonical(bins.size());
+    for (std::size_t k = 0; k < signature.bin_ranks.size(); ++k) {
+        bin_canonical[signature.bin_ranks[k]] = static_cast<uint32_t>(k);
+    }
+
+    // Bins hold references into `items`; whatever no bin holds went unfit
+    CachedResult result;
+    std::vector<bool> placed(items.size(), false);
+    for (std::size_t b = 0; b < bins.size(); ++b) {
+        for (const auto& ref : bins[b].getItems()) {
+            const Item& item = ref.get();
+            const std::size_t index = static_cast<std::size_t>(&item - items.data());
+            const auto& [x, y, z] = item.getPosition();
+            result.placements.push_back({item_canonical[index], bin_canonical[b], {x, y, z}, item.getRotationType()});
+            placed[index] = true;
+        }
+    }
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (!placed[i]) {
+            result.unfit.push_back(item_canonical[i]);
+        }
+    }
+    return result;
+}
+
+std::optional<OnlinePlacement> Packer::placeNext(const Item& item) {
+    online_items.push_back(item);
+    online_buffer.push_back(&online_items.back());
+    if (online_buffer.size() <= options.lookahead) {
+        return std::nullopt;
+    }
+    return commitOnline();
+}
+
+std::vector<OnlinePlacement> Packer::flushOnline() {
+    std::vector<OnlinePlacement> placements;
+    while (!online_buffer.empty()) {
+        placements.push_back(commitOnline());
+    }
+    return placements;
+}
+
+const std::deque<Item>& Packer::getOnlineItems() const {
+    return online_items;
+}
+
+OnlinePlacement Packer::commitOnline() {
+    auto next = std::min_element(online_buffer.begin(), online_buffer.end(), [](const Item* a, const Item* b) {
+        if (constraintRank(*a) != constraintRank(*b)) {
+            return constraintRank(*a) < constraintRank(*b);
+        }
+        return a->getVolume() > b->getVolume();
+    });
+    Item& item = **next;
+    online_buffer.erase(next);
+
+    for (std::size_t position : open_bins) {
+        if (placeAtCandidates(bins[position], item, true)) {
+            return {&item, &bins[position]};
+        }
+    }
+
+    // Open another bin, closing the oldest open bin if that makes too many
+    std::optional<std::size_t> opened = placeInEmptyBin(item, true);
+    if (!opened) {
+        unfit_items.push_back(item);
+        return {&item, nullptr};
+    }
+    open_bins.push_back(*opened);
+    if (open_bins.size() > std::max<std::size_t>(1, options.max_open_bins)) {
+        open_bins.erase(open_bins.begin());
+    }
+    return {&item, &bins[*opened]};
+}
+
+std::optional<std::size_t> Packer::placeInEmptyBin(Item& item, bool online) {
+    std::optional<std::size_t> opened;
+    getBinIndex().forEachCandidate(item.getVolume(), false, sortedDimensions(item), [&](std::size_t position) {
+        Bin& bin = bins[position];
+        if (!bin.getItems().empty() || !bin.probe(item) || !placeAtCandidates(bin, item, online)) {
+            return false;
+        }
+        opened = position;
+        return true;
+    });
+    return opened;
+}
+
+bool Packer::keepPlacement(Bin& bin, Item& item, const PackedItem& placement) {
+    const uint8_t allowed = allowedMask(item);
+    const int rotation = static_cast<int>(placement.rotation);
+    if (allowed ? !((allowed >> rotation) & 1) : placement.rotation != RotationType::whd) {
+        return false;
+    }
+    item.setRotationType(placement.rotation);
+    if (!bin.canItemFit(item, placement.position) ||
+        (options.min_support > 0 && !isSupported(bin, item.getGeometry(placement.rotation, placement.position)))) {
+        return false;
+    }
+    item.setPosition(placement.position);
+    std::size_t mark = bin.checkpoint();
+    bin.addItem(item);
+    if (!checkStuffingConstraints(bin, item, placement.position) ||
+        wouldViolateExistingItemConstraints(bin, item)) {
+        bin.rollback(mark);
+        return false;
+    }
+    return true;
+}
+
+bool Packer::placeItemAt(Bin& bin, Item& item, const std::tuple<long, long, long>& position) {
+    for (int rotation = 0; rotation < 6; ++rotation) {
+        if (keepPlacement(bin, item, {0, 0, position, static_cast<RotationType>(rotation)})) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Packer::repack(const PackResult& previous, const OrderDelta& delta) {
+    for (const auto& placement : previous.placements) {
+        if (placement.item >= items.size() || placement.bin >= bins.size()) {
+            return false;
+        }
+    }
+    for (std::size_t index : delta.removed) {
+        if (index >= items.size()) {
+            return false;
+        }
+    }
+
+    stop_time = std::chrono::steady_clock::now() + options.time_limit;
+    stop_reason = PackStop::FINISHED;
+
+    // Bins refer into `items`, so empty them before the items move
+    for (auto& bin : bins) {
+        bin.setItems({});
+    }
+    unfit_items.clear();
+
+    constexpr std::size_t REMOVED = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> moved_to(items.size(), 0);
+    for (std::size_t index : delta.removed) {
+        moved_to[index] = REMOVED;
+    }
+    std::vector<Item> kept;
+    kept.reserve(items.size() + delta.added.size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (moved_to[i] != REMOVED) {
+            moved_to[i] = kept.size();
+            kept.push_back(std::move(items[i]));
+        }
+    }
+    kept.insert(kept.end(), delta.added.begin(), delta.added.end());
+    items = std::move(kept);
+    expandItemTypes();
+
+    // Put the kept placements back bottom up, so each one is checked against
+    // the items it stands on. A bin that lost an item has room to fill.
+    std::vector<const PackedItem*> replay;
+    replay.reserve(previous.placements.size());
+    std::vector<bool> affected(bins.size(), false);
+    for (const auto& placement : previous.placements) {
+        if (moved_to[placement.item] == REMOVED) {
+            affected[placement.bin] = true;
+        } else {
+            replay.push_back(&placement);
+        }
+    }
+    std::stable_sort(replay.begin(), replay.end(), [](const PackedItem* a, const PackedItem* b) {
+        return std::get<1>(a->position) < std::get<1>(b->position);
+    });
+    std::vector<bool> placed(items.size(), false);
+    for (const PackedItem* placement : replay) {
+        const std::size_t index = moved_to[placement->item];
+        if (keepPlacement(bins[placement->bin], items[index], *placement)) {
+            placed[index] = true;
+        } else {
+            affected[placement->bin] = true;
+        }
+    }
+
+    // The rest go in pack()'s volume order
+    std::vector<Item*> pending;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (!placed[i]) {
+            pending.push_back(&items[i]);
+        }
+    }
+    std::stable_sort(pending.begin(), pending.end(), [](const Item* a, const Item* b) {
+        if (constraintRank(*a) != constraintRank(*b)) {
+            return constraintRank(*a) < constraintRank(*b);
+        }
+        return a->getVolume() > b->getVolume();
+    });
+    std::vector<std::size_t> used_bins;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (std::size_t b = 0; b < bins.size(); ++b) {
+            if (!bins[b].getItems().empty() && affected[b] == (pass == 0)) {
+                used_bins.push_back(b);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        if (shouldStop()) {
+            for (std::size_t j = i; j < pending.size(); ++j) {
+                unfit_items.push_back(*pending[j]);
+            }
+            break;
+        }
+        Item& item = *pending[i];
+        bool fitted = false;
+        for (std::size_t b : used_bins) {
+            if (placeAtCandidates(bins[b], item)) {
+                fitted = true;
+                break;
+            }
+        }
+        if (!fitted) {
+            if (std::optional<std::size_t> opened = placeInEmptyBin(item)) {
+                used_bins.push_back(*opened);
+            } else {
+                unfit_items.push_back(item);
+            }
+        }
+    }
+
+    stop_time = std::chrono::steady_clock::time_point::max();
+    reportProgress();
+    return true;
+}
+
+PackResult Packer::getResult() const {
+    PackResult result;
+    std::vector<bool> placed(items.size(), false);
+    for (std::size_t b = 0; b < bins.size(); ++b) {
+        for (const auto& ref : bins[b].getItems()) {
+            const Item& item = ref.get();
+            const std::size_t index = static_cast<std::size_t>(&item - items.data());
+            result.placements.push_back({index, b, item.getPosition(), item.getRotationType()});
+            placed[index] = true;
+        }
+    }
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (!placed[i]) {
+            result.unfit.push_back(i);
+        }
+    }
+    return result;
+}
+
+void Packer::packRanked(const std::vector<std::size_t>& ranking) {
+    stop_time = std::chrono::steady_clock::now() + options.time_limit;
+    stop_reason = PackStop::FINISHED;
+
+    expandItemTypes();
+    for (auto& bin : bins) {
+        bin.setItems({});
+    }
+    unfit_items.clear();
+    // Poses left by the previous order would steer the candidate checks
+    for (auto& item : items) {
+        item.setRotationType(item.getAllowedRotations()[0]);
+        item.setPosition({0, 0, 0});
+    }
+    std::sort(bins.begin(), bins.end(), [](const Bin& a, const Bin& b) {
+        return a.getVolume() < b.getVolume();
+    });
+    bin_index.build(bins);
+
+    // Constrained items still go first, as in every order
+    std::vector<Item*> remaining_items;
+    remaining_items.reserve(items.size());
+    for (std::size_t index : ranking) {
+        if (index < items.size()) {
+            remaining_items.push_back(&items[index]);
+        }
+    }
+    std::stable_sort(remaining_items.begin(), remaining_items.end(), [](const Item* a, const Item* b) {
+        return constraintRank(*a) < constraintRank(*b);
+    });
+
+    packRemaining(remaining_items);
+
+    stop_time = std::chrono::steady_clock::time_point::max();
+    reportProgress();
+}
+
+void Packer::packRemaining(std::vector<Item*>& remaining_items) {
+    if (options.identical_fast_path && allIdentical(remaining_items)) {
+        packIdentical(remaining_items);
+    } else if (options.strategy == PackStrategy::WALLS) {
+        packWalls(remaining_items);
+    }
+
+    while (!remaining_items.empty()) {
+        // Check time limit and cancellation
+        if (shouldStop()) {
+            // Keep the best solution so far; what is left was never tried
+            for (Item* item : remaining_items) {
+                unfit_items.push_back(*item);
             }
+            break;
         }
         
-        // Find a bin for this batch
-        auto bin = findFittedBin(*batch_items[0]);
+        // Find a bin for the next item (largest volume first); packToBin
+        // then carries on with the rest
+        auto bin = findFittedBin(*remaining_items[0]);
         if (!bin) {
             // No bin fits, mark as unfit
             unfitItem(remaining_items);
+            reportProgress();
             continue;
         }
         
@@ -630,5 +1450,107 @@ void Packer::pack() {
         
         // Update remaining items
         remaining_items = unpacked_items;
+        reportProgress();
     }
 }
+
+void Packer::pack() {
+    pack(ItemOrder::VOLUME);
+}
+
+void Packer::pack(ItemOrder order, uint32_t seed) {
+    // Start timing
+    stop_time = std::chrono::steady_clock::now() + options.time_limit;
+    stop_reason = PackStop::FINISHED;
+
+    expandItemTypes();
+
+    // Sort bins by volume (smallest to largest)
+    std::sort(bins.begin(), bins.end(), [](const Bin& a, const Bin& b) {
+        return a.getVolume() < b.getVolume();
+    });
+    bin_index.build(bins);
+    
+    if (order == ItemOrder::RANDOM) {
+        std::mt19937 rng(seed);
+        std::shuffle(items.begin(), items.end(), rng);
+        std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+            return constraintRank(a) < constraintRank(b);
+        });
+    } else if (order != ItemOrder::VOLUME) {
+        std::stable_sort(items.begin(), items.end(), [order](const Item& a, const Item& b) {
+            if (constraintRank(a) != constraintRank(b)) {
+                return constraintRank(a) < constraintRank(b);
+            }
+            double a_key = orderKey(a, order);
+            double b_key = orderKey(b, order);
+            if (a_key != b_key) {
+                return a_key > b_key;
+            }
+            return a.getVolume() > b.getVolume();
+        });
+    } else {
+        // Sort items by volume (largest to smallest) for better packing
+        // And prioritize items with constraints
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+            // Give highest priority to items with layer constraints
+            bool a_has_layer_constraint = a.getStuffingLayers() > 0;
+            bool b_has_layer_constraint = b.getStuffingLayers() > 0;
+        
+            if (a_has_layer_constraint && !b_has_layer_constraint)
+                return true;
+            if (!a_has_layer_constraint && b_has_layer_constraint)
+                return false;
+            
+            // Then prioritize other constraints
+            bool a_has_other_constraints = a.getStuffingMaxWeight() > 0 || 
+                                         a.getStuffingHeight() > 0 ||
+                                         a.isHeightConstrained();
+                                     
+            bool b_has_other_constraints = b.getStuffingMaxWeight() > 0 || 
+                                         b.getStuffingHeight() > 0 ||
+                                         b.isHeightConstrained();
+        
+            // If one has constraints and the other doesn't, prioritize the constrained one
+            if (a_has_other_constraints && !b_has_other_constraints)
+                return true;
+            if (!a_has_other_constraints && b_has_other_constraints)
+                return false;
+        
+            // Otherwise sort by volume as before
+            return a.getVolume() > b.getVolume();
+        });
+    }
+
+    // Replay the stored result of an order of the same shape, or sign this
+    // one to store its result. Only a fresh pack is cached.
+    std::optional<OrderSignature> signature;
+    const bool fresh = unfit_items.empty() &&
+                       std::all_of(bins.begin(), bins.end(), [](const Bin& bin) { return bin.getItems().empty(); });
+    if (options.result_cache && fresh) {
+        const std::string settings = "order=" + std::to_string(static_cast<int>(order)) + ",seed=" + std::to_string(seed) +
+                                     "," + placementSettings(options);
+        signature = signOrder(bins, items, settings);
+        std::optional<CachedResult> cached = options.result_cache->find(signature->key);
+        if (cached && replayResult(*signature, *cached)) {
+            stop_time = std::chrono::steady_clock::time_point::max();
+            reportProgress();
+            return;
+        }
+    }
+
+    std::vector<Item*> remaining_items;
+    remaining_items.reserve(items.size());
+    for (auto& itm : items) {
+        remaining_items.push_back(&itm);
+    }
+
+    packRemaining(remaining_items);
+
+    if (signature && stop_reason == PackStop::FINISHED) {
+        options.result_cache->store(signature->key, recordResult(*signature));
+    }
+
+    stop_time = std::chrono::steady_clock::time_point::max();
+    reportProgress();
+}
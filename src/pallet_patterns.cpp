@@ -0,0 +1,111 @@
+#include "pallet_patterns.h"
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+bool PalletKey::operator<(const PalletKey& other) const {
+    return std::tie(box, allowed, box_weight, bin, bin_max_weight) <
+           std::tie(other.box, other.allowed, other.box_weight, other.bin, other.bin_max_weight);
+}
+
+PalletPattern solvePalletPattern(const PalletKey& key) {
+    // Most boxes the weight limit lets the bin take
+    std::size_t weight_cap = std::numeric_limits<std::size_t>::max();
+    if (key.bin_max_weight > 0 && key.box_weight > 0) {
+        weight_cap = static_cast<std::size_t>(key.bin_max_weight / key.box_weight);
+    }
+
+    PalletPattern best;
+    std::size_t best_count = 0;
+    for (std::size_t r = 0; r < ROTATION_COUNT; ++r) {
+        if (!(key.allowed & (1u << r))) {
+            continue;
+        }
+        const auto rotation = static_cast<RotationType>(r);
+        const auto dim = rotateDimension(key.box[0], key.box[1], key.box[2], rotation);
+        if (dim[1] <= 0 || dim[1] > key.bin[1]) {
+            continue;
+        }
+
+        // The same box turned a quarter on the floor, if it may stand that way
+        std::optional<RotationType> turned;
+        for (std::size_t other = 0; other < ROTATION_COUNT && dim[0] != dim[2]; ++other) {
+            if ((key.allowed & (1u << other)) &&
+                rotateDimension(key.box[0], key.box[1], key.box[2], static_cast<RotationType>(other)) ==
+                    std::array<long, 3>{dim[2], dim[1], dim[0]}) {
+                turned = static_cast<RotationType>(other);
+                break;
+            }
+        }
+
+        std::vector<FaceCell> cells = guillotinePattern(key.bin[0], key.bin[2], dim[0], dim[2], turned.has_value());
+        const std::size_t layers = static_cast<std::size_t>(key.bin[1] / dim[1]);
+        const std::size_t count = std::min(cells.size() * layers, weight_cap);
+        if (count > best_count || (count == best_count && count > 0 && layers < best.layers)) {
+            best_count = count;
+            best.rotation = rotation;
+            best.turned = turned.value_or(rotation);
+            best.layer_height = dim[1];
+            best.layers = layers;
+            best.capacity = count;
+            best.cells = std::move(cells);
+        }
+    }
+    return best;
+}
+
+PalletPatternCache::PalletPatternCache(std::size_t capacity) : LruCache(capacity) {}
+
+PalletPattern PalletPatternCache::lookup(const PalletKey& key) {
+    if (std::optional<PalletPattern> cached = find(key)) {
+        return *cached;
+    }
+    // Solve outside the lock; two threads missing on one key solve it twice
+    PalletPattern pattern = solvePalletPattern(key);
+    store(key, pattern);
+    return pattern;
+}
+
+// File format, one pattern per line:
+//   box w h d, allowed, box weight, bin w h d, bin max weight,
+//   rotation, turned, layer height, layers, capacity, cell count, then x z turned per cell
+bool PalletPatternCache::save(const std::string& path) const {
+    return saveEntries(path, [](std::ostream& out, const PalletKey& key, const PalletPattern& pattern) {
+        out << std::setprecision(std::numeric_limits<float>::max_digits10);
+        out << key.box[0] << ' ' << key.box[1] << ' ' << key.box[2] << ' ' << int(key.allowed) << ' '
+            << key.box_weight << ' ' << key.bin[0] << ' ' << key.bin[1] << ' ' << key.bin[2] << ' '
+            << key.bin_max_weight << ' ' << int(pattern.rotation) << ' ' << int(pattern.turned) << ' '
+            << pattern.layer_height << ' ' << pattern.layers << ' ' << pattern.capacity << ' ' << pattern.cells.size();
+        for (const auto& cell : pattern.cells) {
+            out << ' ' << cell.x << ' ' << cell.y << ' ' << int(cell.turned);
+        }
+        out << '\n';
+    });
+}
+
+bool PalletPatternCache::load(const std::string& path) {
+    return loadEntries(path, [](std::istream& in, PalletKey& key, PalletPattern& pattern) {
+        int allowed, rotation, turned;
+        std::size_t cell_count;
+        if (!(in >> key.box[0] >> key.box[1] >> key.box[2] >> allowed >> key.box_weight >>
+              key.bin[0] >> key.bin[1] >> key.bin[2] >> key.bin_max_weight) ||
+            !(in >> rotation >> turned >> pattern.layer_height >> pattern.layers >> pattern.capacity >> cell_count) ||
+            rotation < 0 || rotation >= int(ROTATION_COUNT) || turned < 0 || turned >= int(ROTATION_COUNT)) {
+            return false;
+        }
+        key.allowed = static_cast<uint8_t>(allowed);
+        pattern.rotation = static_cast<RotationType>(rotation);
+        pattern.turned = static_cast<RotationType>(turned);
+        pattern.cells.resize(cell_count);
+        for (auto& cell : pattern.cells) {
+            int cell_turned;
+            if (!(in >> cell.x >> cell.y >> cell_turned)) {
+                return false;
+            }
+            cell.turned = cell_turned != 0;
+        }
+        return true;
+    });
+}
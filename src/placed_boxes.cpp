@@ -0,0 +1,112 @@
+#include "placed_boxes.h"
+#include <algorithm>
+
+uint8_t placementFlags(const Item& item) {
+    uint8_t flags = 0;
+    if (item.isBottomLoadOnlyEnabled()) {
+        flags |= PLACED_BOTTOM_LOAD_ONLY;
+    }
+    if (item.isDisableStackingEnabled()) {
+        flags |= PLACED_DISABLE_STACKING;
+    }
+    if (item.isHeightConstrained()) {
+        flags |= PLACED_HEIGHT_CONSTRAINED;
+    }
+    if (item.getStuffingLayers() > 0 || item.getStuffingMaxWeight() > 0 || item.getStuffingHeight() > 0) {
+        flags |= PLACED_STUFFING_LIMITS;
+    }
+    return flags;
+}
+
+std::size_t PlacedBoxes::size() const {
+    return weight.size();
+}
+
+void PlacedBoxes::push(const ItemGeometry& geometry, uint8_t item_flags) {
+    const auto& p = geometry.position;
+    const auto& d = geometry.dimension;
+    min_x.push_back(p[0]);
+    min_y.push_back(p[1]);
+    min_z.push_back(p[2]);
+    max_x.push_back(p[0] + d[0]);
+    max_y.push_back(p[1] + d[1]);
+    max_z.push_back(p[2] + d[2]);
+    weight.push_back(geometry.weight);
+    flags.push_back(item_flags);
+
+    // Fold the box into the running totals
+    PlacedTotals next = total();
+    long volume = d[0] * d[1] * d[2];
+    next.weight += geometry.weight;
+    next.volume += volume;
+    for (int axis = 0; axis < 3; ++axis) {
+        double centre = p[axis] + d[axis] / 2.0;
+        next.weight_moment[axis] += geometry.weight * centre;
+        next.volume_moment[axis] += volume * centre;
+        if (totals.empty()) {
+            next.bounds.min[axis] = p[axis];
+            next.bounds.max[axis] = p[axis] + d[axis];
+        } else {
+            next.bounds.min[axis] = std::min(next.bounds.min[axis], p[axis]);
+            next.bounds.max[axis] = std::max(next.bounds.max[axis], p[axis] + d[axis]);
+        }
+    }
+    totals.push_back(next);
+}
+
+void PlacedBoxes::pop() {
+    min_x.pop_back();
+    min_y.pop_back();
+    min_z.pop_back();
+    max_x.pop_back();
+    max_y.pop_back();
+    max_z.pop_back();
+    weight.pop_back();
+    flags.pop_back();
+    totals.pop_back();
+}
+
+void PlacedBoxes::clear() {
+    min_x.clear();
+    min_y.clear();
+    min_z.clear();
+    max_x.clear();
+    max_y.clear();
+    max_z.clear();
+    weight.clear();
+    flags.clear();
+    totals.clear();
+}
+
+const PlacedTotals& PlacedBoxes::total() const {
+    static const PlacedTotals empty;
+    return totals.empty() ? empty : totals.back();
+}
+
+GridBox PlacedBoxes::box(std::size_t index) const {
+    return GridBox{
+        {min_x[index], min_y[index], min_z[index]},
+        {max_x[index], max_y[index], max_z[index]}
+    };
+}
+
+bool PlacedBoxes::overlaps(std::size_t index, const GridBox& other) const {
+    return min_x[index] < other.max[0] && other.min[0] < max_x[index] &&
+           min_y[index] < other.max[1] && other.min[1] < max_y[index] &&
+           min_z[index] < other.max[2] && other.min[2] < max_z[index];
+}
+
+long PlacedBoxes::baseArea(std::size_t index) const {
+    return (max_x[index] - min_x[index]) * (max_z[index] - min_z[index]);
+}
+
+float PlacedBoxes::baseOverlap(std::size_t index, const GridBox& other) const {
+    // Same float arithmetic as Packer::calculateItemOverlap
+    float overlap_x = std::max(0.0f,
+        std::min(static_cast<float>(max_x[index]), static_cast<float>(other.max[0])) -
+        std::max(static_cast<float>(min_x[index]), static_cast<float>(other.min[0])));
+    float overlap_z = std::max(0.0f,
+        std::min(static_cast<float>(max_z[index]), static_cast<float>(other.max[2])) -
+        std::max(static_cast<float>(min_z[index]), static_cast<float>(other.min[2])));
+    return overlap_x * overlap_z;
+}
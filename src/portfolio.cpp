@@ -0,0 +1,113 @@
+#include "portfolio.h"
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include "work_pool.h"
+
+const std::vector<ItemOrder> ITEM_ORDERS = {
+    ItemOrder::VOLUME,
+    ItemOrder::LONGEST_EDGE,
+    ItemOrder::BASE_AREA,
+    ItemOrder::WEIGHT,
+    ItemOrder::RANDOM
+};
+
+double packedVolume(const Packer& packer) {
+    double volume = 0;
+    for (const auto& bin : packer.getBins()) {
+        volume += static_cast<double>(bin.getUsedVolume());
+    }
+    return volume;
+}
+
+std::size_t binsUsed(const Packer& packer) {
+    std::size_t used = 0;
+    for (const auto& bin : packer.getBins()) {
+        used += bin.getItems().empty() ? 0 : 1;
+    }
+    return used;
+}
+
+bool packsBetter(double volume, long bins, double other_volume, long other_bins, PortfolioObjective objective) {
+    if (objective == PortfolioObjective::BINS_USED && bins != other_bins) {
+        return bins < other_bins;
+    }
+    if (volume != other_volume) {
+        return volume > other_volume;
+    }
+    return bins < other_bins;
+}
+
+// Whether run a beats run b under the built-in objectives
+static bool betterRun(const PortfolioRun& a, const PortfolioRun& b, PortfolioObjective objective) {
+    return packsBetter(a.packed_volume, static_cast<long>(a.bins_used), b.packed_volume,
+                       static_cast<long>(b.bins_used), objective);
+}
+
+PortfolioResult packPortfolio(Packer& packer, const PortfolioOptions& options) {
+    const std::size_t run_count = std::max<std::size_t>(1, options.runs);
+    // Runs share the packer's cancel token and stop at the earlier of its
+    // deadline and ours; progress is not reported from the workers
+    const PackOptions caller_options = packer.getOptions();
+    PackOptions run_options = caller_options;
+    run_options.deadline = std::chrono::steady_clock::now() + options.budget;
+    if (caller_options.deadline) {
+        run_options.deadline = std::min(*run_options.deadline, *caller_options.deadline);
+    }
+    run_options.progress = nullptr;
+
+    PortfolioResult result;
+    for (std::size_t k = 0; k < run_count; ++k) {
+        ItemOrder order = k + 1 < ITEM_ORDERS.size() ? ITEM_ORDERS[k] : ItemOrder::RANDOM;
+        result.runs.push_back({order, options.seed + static_cast<uint32_t>(k), 0, 0, 0, false});
+    }
+
+    // Every run packs its own copy; the pool drains all runs before it is destroyed
+    std::vector<std::optional<Packer>> packed(run_count);
+    std::vector<std::exception_ptr> errors(run_count);
+    {
+        WorkPool pool(std::min(run_count, std::max<std::size_t>(1, options.threads)));
+        for (std::size_t k = 0; k < run_count; ++k) {
+            pool.submit([&, k](std::size_t) {
+                try {
+                    Packer copy(packer);
+                    copy.setOptions(run_options);
+                    copy.pack(result.runs[k].order, result.runs[k].seed);
+                    result.runs[k].finished = copy.getStopReason() == PackStop::FINISHED;
+                    packed[k] = std::move(copy);
+                } catch (...) {
+                    errors[k] = std::current_exception();
+                }
+            });
+        }
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Pick the winner on this thread, in run order, so ties are deterministic
+    std::vector<double> scores(run_count);
+    for (std::size_t k = 0; k < run_count; ++k) {
+        PortfolioRun& run = result.runs[k];
+        run.packed_volume = packedVolume(*packed[k]);
+        run.bins_used = binsUsed(*packed[k]);
+        run.unfit = packed[k]->getUnfitItems().size();
+        if (options.score) {
+            scores[k] = options.score(*packed[k]);
+        }
+    }
+    result.best = 0;
+    for (std::size_t k = 1; k < run_count; ++k) {
+        bool better = options.score ? scores[k] > scores[result.best]
+                                    : betterRun(result.runs[k], result.runs[result.best], options.objective);
+        if (better) {
+            result.best = k;
+        }
+    }
+
+    packer = std::move(*packed[result.best]);
+    packer.setOptions(caller_options);
+    return result;
+}
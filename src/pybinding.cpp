@@ -1,17 +1,50 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/functional.h>
 #include <pybind11/operators.h>  // Include this header for py::self
+#include <pybind11/numpy.h>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 #include "box.h"
 #include "item.h"
 // Make sure we're including the correct bin.h
 #include "bin.h"
 // Ensure packer.h is included from the right path
 #include "../include/packer.h" // or "packer.h" if in the same directory
+#include "portfolio.h"
+#include "local_search.h"
+#include "brkga.h"
+#include "pack_columns.h"
 
 namespace py = pybind11;
 
+// C-contiguous view of a NumPy array, converted only if its dtype or layout differ
+template <typename T>
+using Column = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+// Data pointer of an optional column holding one value per row
+template <typename T>
+static const T* columnData(const std::optional<Column<T>>& column, std::size_t rows, const char* name) {
+    if (!column) {
+        return nullptr;
+    }
+    if (column->ndim() != 1 || static_cast<std::size_t>(column->shape(0)) != rows) {
+        throw std::invalid_argument(std::string(name) + " must have one value per row");
+    }
+    return column->data();
+}
+
+static std::size_t dimensionRows(const Column<long>& dims, const char* name) {
+    if (dims.ndim() != 2 || dims.shape(1) != 3) {
+        throw std::invalid_argument(std::string(name) + " must have shape (n, 3)");
+    }
+    return static_cast<std::size_t>(dims.shape(0));
+}
+
 PYBIND11_MODULE(pybinding, m) {
+    PYBIND11_NUMPY_DTYPE(PlacementRecord, item, bin, x, y, z, rotation);
+
     py::class_<Box>(m, "Box")
         .def(py::init<const std::string&, long, long, long>())
         .def("get_name", &Box::getName)
@@ -28,6 +61,30 @@ PYBIND11_MODULE(pybinding, m) {
         .value("dwh", RotationType::dwh)
         .value("wdh", RotationType::wdh);
 
+    py::enum_<ItemOrder>(m, "ItemOrder")
+        .value("volume", ItemOrder::VOLUME)
+        .value("longest_edge", ItemOrder::LONGEST_EDGE)
+        .value("base_area", ItemOrder::BASE_AREA)
+        .value("weight", ItemOrder::WEIGHT)
+        .value("random", ItemOrder::RANDOM);
+
+    py::enum_<PortfolioObjective>(m, "PortfolioObjective")
+        .value("packed_volume", PortfolioObjective::PACKED_VOLUME)
+        .value("bins_used", PortfolioObjective::BINS_USED);
+
+    py::enum_<PackStop>(m, "PackStop")
+        .value("finished", PackStop::FINISHED)
+        .value("deadline", PackStop::DEADLINE)
+        .value("cancelled", PackStop::CANCELLED);
+
+    py::enum_<PackStrategy>(m, "PackStrategy")
+        .value("item_by_item", PackStrategy::ITEM_BY_ITEM)
+        .value("walls", PackStrategy::WALLS);
+
+    py::enum_<PlacementModel>(m, "PlacementModel")
+        .value("extreme_points", PlacementModel::EXTREME_POINTS)
+        .value("maximal_spaces", PlacementModel::MAXIMAL_SPACES);
+
     py::enum_<Axis>(m, "Axis")
         .value("width", Axis::width)
         .value("height", Axis::height)
@@ -118,6 +175,7 @@ PYBIND11_MODULE(pybinding, m) {
         .def_readwrite("rotation_type", &Item::_rotation_type)
         .def_readwrite("name", &Item::name, py::return_value_policy::reference)
         .def_readwrite("weight", &Item::weight)
+        .def_readonly("type_id", &Item::type_id)
         // Add stuffing properties
         .def_readwrite("stuffing_layers", &Item::_stuffing_layers)
         .def_readwrite("stuffing_max_weight", &Item::_stuffing_max_weight)
@@ -146,7 +204,17 @@ PYBIND11_MODULE(pybinding, m) {
         .def("put_item", &Bin::putItem)
         .def("add_item", &Bin::addItem)
         .def("remove_item", &Bin::removeItem)
-        .def_readwrite("items", &Bin::items)
+        .def("probe", &Bin::probe)
+        .def("get_total_weight", &Bin::getTotalWeight)
+        .def("get_used_volume", &Bin::getUsedVolume)
+        .def("get_fill_ratio", &Bin::getFillRatio)
+        .def("get_load_bounds", [](const Bin& bin) {
+            GridBox bounds = bin.getLoadBounds();
+            return std::make_pair(bounds.min, bounds.max);
+        })
+        .def("get_max_occupied", &Bin::getMaxOccupied)
+        .def("get_center_of_mass", &Bin::getCenterOfMass)
+        .def_property("items", &Bin::getItems, &Bin::setItems)
         .def_readwrite("name", &Box::name, py::return_value_policy::reference)
         .def_readwrite("width", &Box::width)
         .def_readwrite("height", &Box::height)
@@ -157,6 +225,75 @@ PYBIND11_MODULE(pybinding, m) {
         .def_readwrite("id", &Bin::id)
         .def("to_string", &Bin::toString);
 
+    py::class_<CancelToken>(m, "CancelToken")
+        .def(py::init<>())
+        .def("cancel", &CancelToken::cancel)
+        .def("is_cancelled", &CancelToken::isCancelled);
+
+    py::class_<PackProgress>(m, "PackProgress")
+        .def_readonly("items_placed", &PackProgress::items_placed)
+        .def_readonly("items_unfit", &PackProgress::items_unfit)
+        .def_readonly("items_total", &PackProgress::items_total)
+        .def_readonly("bins_opened", &PackProgress::bins_opened)
+        .def_readonly("fill_rate", &PackProgress::fill_rate);
+
+    py::class_<PalletPatternCache, std::shared_ptr<PalletPatternCache>>(m, "PalletPatternCache")
+        .def(py::init<std::size_t>(), py::arg("capacity") = 1024)
+        .def("size", &PalletPatternCache::size)
+        .def("hits", &PalletPatternCache::hits)
+        .def("misses", &PalletPatternCache::misses)
+        .def("save", &PalletPatternCache::save)
+        .def("load", &PalletPatternCache::load);
+
+    py::class_<PackResultCache, std::shared_ptr<PackResultCache>>(m, "PackResultCache")
+        .def(py::init<std::size_t, std::size_t>(), py::arg("max_entries") = 1024, py::arg("max_placements") = 1 << 20)
+        .def("size", &PackResultCache::size)
+        .def("hits", &PackResultCache::hits)
+        .def("misses", &PackResultCache::misses)
+        .def("save", &PackResultCache::save)
+        .def("load", &PackResultCache::load);
+
+    py::class_<PackOptions>(m, "PackOptions")
+        .def(py::init<>())
+        .def_property("time_limit_ms",
+            [](const PackOptions& options) { return static_cast<long>(options.time_limit.count()); },
+            [](PackOptions& options, long ms) { options.time_limit = std::chrono::milliseconds(ms); })
+        .def_readwrite("cancel", &PackOptions::cancel)
+        .def_readwrite("progress", &PackOptions::progress)
+        .def_readwrite("strategy", &PackOptions::strategy)
+        .def_readwrite("placement", &PackOptions::placement)
+        .def_readwrite("best_fit", &PackOptions::best_fit)
+        .def_readwrite("min_support", &PackOptions::min_support)
+        .def_readwrite("support_cell", &PackOptions::support_cell)
+        .def_readwrite("identical_fast_path", &PackOptions::identical_fast_path)
+        .def_readwrite("pallet_patterns", &PackOptions::pallet_patterns)
+        .def_readwrite("result_cache", &PackOptions::result_cache)
+        .def_readwrite("lookahead", &PackOptions::lookahead)
+        .def_readwrite("max_open_bins", &PackOptions::max_open_bins)
+        .def_readwrite("online_candidates", &PackOptions::online_candidates);
+
+    py::class_<PackedItem>(m, "PackedItem")
+        .def(py::init<std::size_t, std::size_t, std::tuple<long, long, long>, RotationType>(),
+             py::arg("item"), py::arg("bin"), py::arg("position"), py::arg("rotation"))
+        .def_readwrite("item", &PackedItem::item)
+        .def_readwrite("bin", &PackedItem::bin)
+        .def_readwrite("position", &PackedItem::position)
+        .def_readwrite("rotation", &PackedItem::rotation);
+
+    py::class_<PackResult>(m, "PackResult")
+        .def(py::init<>())
+        .def_readwrite("placements", &PackResult::placements)
+        .def_readwrite("unfit", &PackResult::unfit);
+
+    py::class_<OrderDelta>(m, "OrderDelta")
+        .def(py::init<>())
+        .def_readwrite("removed", &OrderDelta::removed)
+        .def_readwrite("added", &OrderDelta::added);
+
+    py::class_<OnlinePlacement>(m, "OnlinePlacement")
+        .def_readonly("item", &OnlinePlacement::item, py::return_value_policy::reference)
+        .def_readonly("bin", &OnlinePlacement::bin, py::return_value_policy::reference);
+
     py::class_<Packer>(m, "Packer")
         .def(py::init<>())
         .def("get_bins", &Packer::getBins)
@@ -164,12 +301,173 @@ PYBIND11_MODULE(pybinding, m) {
         .def("get_unfit_items", &Packer::getUnfitItems)
         .def("add_bin", &Packer::addBin)
         .def("add_item", &Packer::addItem)
+        .def("add_item_type", &Packer::addItemType, py::arg("prototype"), py::arg("quantity"))
+        .def("get_packed_quantities", &Packer::getPackedQuantities)
         .def("find_fitted_bin", &Packer::findFittedBin)
-        .def("get_bigger_bin_than", &Packer::getBiggerBinThan)
+        .def("get_bigger_bin_than", py::overload_cast<const Bin&>(&Packer::getBiggerBinThan))
+        .def("get_bigger_bin_than", py::overload_cast<const Bin&, const Item&>(&Packer::getBiggerBinThan))
         .def("unfit_item", &Packer::unfitItem)
         .def("pack_to_bin", &Packer::packToBin)
-        .def("pack", &Packer::pack)
+        .def("pack", py::overload_cast<>(&Packer::pack), py::call_guard<py::gil_scoped_release>())
+        .def("pack", py::overload_cast<ItemOrder, uint32_t>(&Packer::pack),
+             py::arg("order"), py::arg("seed") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("set_options", &Packer::setOptions)
+        .def("get_options", &Packer::getOptions)
+        .def("get_stop_reason", &Packer::getStopReason)
+        .def("get_progress", &Packer::getProgress)
+        .def("repack", &Packer::repack, py::arg("previous"), py::arg("delta"), py::call_guard<py::gil_scoped_release>())
+        .def("get_result", &Packer::getResult)
+        .def("place_next", &Packer::placeNext, py::arg("item"))
+        .def("place_item", &Packer::placeItem, py::arg("bin"), py::arg("item"), py::arg("best_fit") = false)
+        .def("place_item_at", &Packer::placeItemAt, py::arg("bin"), py::arg("item"), py::arg("position"))
+        .def("pack_ranked", &Packer::packRanked, py::arg("ranking"), py::call_guard<py::gil_scoped_release>())
+        .def("flush_online", &Packer::flushOnline)
+        .def("get_online_items", [](const Packer& packer) {
+            return std::vector<Item>(packer.getOnlineItems().begin(), packer.getOnlineItems().end());
+        })
         .def_readwrite("bins", &Packer::bins)
         .def_readwrite("items", &Packer::items)
         .def_readwrite("unfit_items", &Packer::unfit_items);
+
+    py::class_<PortfolioOptions>(m, "PortfolioOptions")
+        .def(py::init<>())
+        .def_readwrite("runs", &PortfolioOptions::runs)
+        .def_readwrite("seed", &PortfolioOptions::seed)
+        .def_readwrite("threads", &PortfolioOptions::threads)
+        .def_property("budget_ms",
+            [](const PortfolioOptions& options) { return static_cast<long>(options.budget.count()); },
+            [](PortfolioOptions& options, long ms) { options.budget = std::chrono::milliseconds(ms); })
+        .def_readwrite("objective", &PortfolioOptions::objective)
+        .def_readwrite("score", &PortfolioOptions::score);
+
+    py::class_<PortfolioRun>(m, "PortfolioRun")
+        .def_readonly("order", &PortfolioRun::order)
+        .def_readonly("seed", &PortfolioRun::seed)
+        .def_readonly("packed_volume", &PortfolioRun::packed_volume)
+        .def_readonly("bins_used", &PortfolioRun::bins_used)
+        .def_readonly("unfit", &PortfolioRun::unfit)
+        .def_readonly("finished", &PortfolioRun::finished);
+
+    py::class_<PortfolioResult>(m, "PortfolioResult")
+        .def_readonly("runs", &PortfolioResult::runs)
+        .def_readonly("best", &PortfolioResult::best);
+
+    m.def("pack_portfolio", &packPortfolio, py::arg("packer"), py::arg("options") = PortfolioOptions(),
+          py::call_guard<py::gil_scoped_release>());
+
+    py::enum_<MoveKind>(m, "MoveKind")
+        .value("insert", MoveKind::INSERT)
+        .value("swap", MoveKind::SWAP)
+        .value("reorient", MoveKind::REORIENT)
+        .value("relocate", MoveKind::RELOCATE)
+        .value("empty_bin", MoveKind::EMPTY_BIN);
+
+    py::class_<ImproveOptions>(m, "ImproveOptions")
+        .def(py::init<>())
+        .def_property("budget_ms",
+            [](const ImproveOptions& options) { return static_cast<long>(options.budget.count()); },
+            [](ImproveOptions& options, long ms) { options.budget = std::chrono::milliseconds(ms); })
+        .def_readwrite("threads", &ImproveOptions::threads)
+        .def_readwrite("moves_per_round", &ImproveOptions::moves_per_round)
+        .def_readwrite("max_idle_rounds", &ImproveOptions::max_idle_rounds)
+        .def_readwrite("seed", &ImproveOptions::seed)
+        .def_readwrite("objective", &ImproveOptions::objective);
+
+    py::class_<ImproveResult>(m, "ImproveResult")
+        .def_readonly("rounds", &ImproveResult::rounds)
+        .def_readonly("evaluated", &ImproveResult::evaluated)
+        .def_readonly("accepted", &ImproveResult::accepted)
+        .def_readonly("packed_volume_before", &ImproveResult::packed_volume_before)
+        .def_readonly("packed_volume_after", &ImproveResult::packed_volume_after)
+        .def_readonly("bins_used_before", &ImproveResult::bins_used_before)
+        .def_readonly("bins_used_after", &ImproveResult::bins_used_after);
+
+    m.def("improve_packing", &improvePacking, py::arg("packer"), py::arg("options") = ImproveOptions(),
+          py::call_guard<py::gil_scoped_release>());
+
+    py::class_<BrkgaGeneration>(m, "BrkgaGeneration")
+        .def_readonly("generation", &BrkgaGeneration::generation)
+        .def_readonly("best_packed_volume", &BrkgaGeneration::best_packed_volume)
+        .def_readonly("best_bins_used", &BrkgaGeneration::best_bins_used)
+        .def_readonly("mean_packed_volume", &BrkgaGeneration::mean_packed_volume)
+        .def_property_readonly("elapsed_ms",
+            [](const BrkgaGeneration& generation) { return static_cast<long>(generation.elapsed.count()); });
+
+    py::class_<BrkgaOptions>(m, "BrkgaOptions")
+        .def(py::init<>())
+        .def_readwrite("population", &BrkgaOptions::population)
+        .def_readwrite("elite_fraction", &BrkgaOptions::elite_fraction)
+        .def_readwrite("mutant_fraction", &BrkgaOptions::mutant_fraction)
+        .def_readwrite("elite_bias", &BrkgaOptions::elite_bias)
+        .def_readwrite("generations", &BrkgaOptions::generations)
+        .def_readwrite("max_stall_generations", &BrkgaOptions::max_stall_generations)
+        .def_property("budget_ms",
+            [](const BrkgaOptions& options) { return static_cast<long>(options.budget.count()); },
+            [](BrkgaOptions& options, long ms) { options.budget = std::chrono::milliseconds(ms); })
+        .def_readwrite("threads", &BrkgaOptions::threads)
+        .def_readwrite("seed", &BrkgaOptions::seed)
+        .def_readwrite("objective", &BrkgaOptions::objective)
+        .def_readwrite("seed_with_greedy", &BrkgaOptions::seed_with_greedy)
+        .def_readwrite("on_generation", &BrkgaOptions::on_generation);
+
+    py::class_<BrkgaResult>(m, "BrkgaResult")
+        .def_readonly("generations", &BrkgaResult::generations)
+        .def_readonly("decoded", &BrkgaResult::decoded)
+        .def_readonly("packed_volume", &BrkgaResult::packed_volume)
+        .def_readonly("bins_used", &BrkgaResult::bins_used)
+        .def_readonly("best_keys", &BrkgaResult::best_keys)
+        .def_readonly("log", &BrkgaResult::log);
+
+    // The generation callback runs on the calling thread, so the GIL is
+    // only released when there is none
+    m.def("pack_brkga", [](Packer& packer, const BrkgaOptions& options) {
+        if (options.on_generation) {
+            return packBrkga(packer, options);
+        }
+        py::gil_scoped_release release;
+        return packBrkga(packer, options);
+    }, py::arg("packer"), py::arg("options") = BrkgaOptions());
+
+    // Bulk packing straight from NumPy columns; returns one PlacementRecord per
+    // item row without building Item objects on the Python side
+    m.def("pack_arrays", [](Packer& packer, const Column<long>& bin_dims, const Column<long>& item_dims,
+                            const std::optional<Column<float>>& bin_max_weight,
+                            const std::optional<Column<float>>& weight,
+                            const std::optional<Column<uint8_t>>& rotation_mask,
+                            const std::optional<Column<int32_t>>& stuffing_layers,
+                            const std::optional<Column<float>>& stuffing_max_weight,
+                            const std::optional<Column<long>>& stuffing_height,
+                            const std::optional<Column<long>>& max_height,
+                            const std::optional<Column<uint8_t>>& bottom_load_only,
+                            const std::optional<Column<uint8_t>>& disable_stacking) {
+        BinColumns bins;
+        bins.count = dimensionRows(bin_dims, "bin_dims");
+        bins.dimensions = bin_dims.data();
+        bins.max_weight = columnData(bin_max_weight, bins.count, "bin_max_weight");
+
+        ItemColumns items;
+        items.count = dimensionRows(item_dims, "item_dims");
+        items.dimensions = item_dims.data();
+        items.weight = columnData(weight, items.count, "weight");
+        items.rotation_mask = columnData(rotation_mask, items.count, "rotation_mask");
+        items.stuffing_layers = columnData(stuffing_layers, items.count, "stuffing_layers");
+        items.stuffing_max_weight = columnData(stuffing_max_weight, items.count, "stuffing_max_weight");
+        items.stuffing_height = columnData(stuffing_height, items.count, "stuffing_height");
+        items.max_height = columnData(max_height, items.count, "max_height");
+        items.bottom_load_only = columnData(bottom_load_only, items.count, "bottom_load_only");
+        items.disable_stacking = columnData(disable_stacking, items.count, "disable_stacking");
+
+        py::array_t<PlacementRecord> result(static_cast<py::ssize_t>(items.count));
+        PlacementRecord* out = result.mutable_data();
+        {
+            py::gil_scoped_release release;
+            packColumns(packer, bins, items, out);
+        }
+        return result;
+    }, py::arg("packer"), py::arg("bin_dims"), py::arg("item_dims"),
+       py::arg("bin_max_weight") = py::none(), py::arg("weight") = py::none(),
+       py::arg("rotation_mask") = py::none(), py::arg("stuffing_layers") = py::none(),
+       py::arg("stuffing_max_weight") = py::none(), py::arg("stuffing_height") = py::none(),
+       py::arg("max_height") = py::none(), py::arg("bottom_load_only") = py::none(),
+       py::arg("disable_stacking") = py::none());
 }
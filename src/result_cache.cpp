@@ -0,0 +1,117 @@
+#include "result_cache.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+// Packing-relevant fields of an item, as text so the key can be written out
+static std::string itemFields(const Item& item) {
+    uint32_t allowed = 0;
+    for (auto rotation : item.getAllowedRotations()) {
+        allowed |= 1u << static_cast<int>(rotation);
+    }
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << item.getWidth() << ',' << item.getHeight() << ',' << item.getDepth() << ',' << allowed << ','
+        << item.weight << ',' << item.getStuffingLayers() << ',' << item.getStuffingMaxWeight() << ','
+        << item.getStuffingHeight() << ',' << item.isHeightConstrained() << ',' << item.getHeightConstraintValue() << ','
+        << static_cast<int>(item.getHeightConstraintType()) << ',' << item.isBottomLoadOnlyEnabled() << ','
+        << item.isDisableStackingEnabled();
+    return out.str();
+}
+
+static std::string binFields(const Bin& bin) {
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << bin.getWidth() << ',' << bin.getHeight() << ',' << bin.getDepth() << ',' << bin.max_weight;
+    return out.str();
+}
+
+// Sort the fields, fill `ranks` with the matching input positions and append
+// the multiset to the key as field*count runs
+static void appendRanked(std::vector<std::string> fields, std::vector<std::size_t>& ranks, std::string& key) {
+    ranks.resize(fields.size());
+    std::iota(ranks.begin(), ranks.end(), 0);
+    std::sort(ranks.begin(), ranks.end(), [&fields](std::size_t a, std::size_t b) {
+        return std::tie(fields[a], a) < std::tie(fields[b], b);
+    });
+    for (std::size_t i = 0; i < ranks.size();) {
+        std::size_t run = i;
+        while (run < ranks.size() && fields[ranks[run]] == fields[ranks[i]]) {
+            ++run;
+        }
+        key += fields[ranks[i]] + '*' + std::to_string(run - i) + ';';
+        i = run;
+    }
+}
+
+OrderSignature signOrder(const std::vector<Bin>& bins, const std::vector<Item>& items, const std::string& settings) {
+    OrderSignature signature;
+    signature.key = settings + "|items:";
+
+    std::vector<std::string> fields;
+    fields.reserve(items.size());
+    for (const auto& item : items) {
+        fields.push_back(itemFields(item));
+    }
+    appendRanked(std::move(fields), signature.item_ranks, signature.key);
+
+    signature.key += "|bins:";
+    fields.clear();
+    for (const auto& bin : bins) {
+        fields.push_back(binFields(bin));
+    }
+    appendRanked(std::move(fields), signature.bin_ranks, signature.key);
+    return signature;
+}
+
+PackResultCache::PackResultCache(std::size_t max_entries, std::size_t max_placements)
+    : LruCache(max_entries, max_placements, [](const CachedResult& result) { return result.placements.size(); }) {}
+
+// File format, one result per line: the key, the placement count, then
+// item bin x y z rotation per placement, the unfit count and the unfit items
+bool PackResultCache::save(const std::string& path) const {
+    return saveEntries(path, [](std::ostream& out, const std::string& key, const CachedResult& result) {
+        out << key << ' ' << result.placements.size();
+        for (const auto& placement : result.placements) {
+            out << ' ' << placement.item << ' ' << placement.bin << ' ' << placement.position[0] << ' '
+                << placement.position[1] << ' ' << placement.position[2] << ' ' << static_cast<int>(placement.rotation);
+        }
+        out << ' ' << result.unfit.size();
+        for (uint32_t item : result.unfit) {
+            out << ' ' << item;
+        }
+        out << '\n';
+    });
+}
+
+bool PackResultCache::load(const std::string& path) {
+    return loadEntries(path, [](std::istream& in, std::string& key, CachedResult& result) {
+        std::size_t count;
+        if (!(in >> key >> count)) {
+            return false;
+        }
+        result.placements.resize(count);
+        for (auto& placement : result.placements) {
+            int rotation;
+            if (!(in >> placement.item >> placement.bin >> placement.position[0] >> placement.position[1] >>
+                  placement.position[2] >> rotation) ||
+                rotation < 0 || rotation >= static_cast<int>(ROTATION_COUNT)) {
+                return false;
+            }
+            placement.rotation = static_cast<RotationType>(rotation);
+        }
+        if (!(in >> count)) {
+            return false;
+        }
+        result.unfit.resize(count);
+        for (auto& item : result.unfit) {
+            if (!(in >> item)) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -0,0 +1,124 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+// Roughly how many cells the grid is split into, whatever the bin shape
+const double TARGET_CELL_COUNT = 4096.0;
+
+SpatialGrid::SpatialGrid()
+    : extent{0, 0, 0}, cell_size{1, 1, 1}, cell_count{1, 1, 1}, entry_count(0) {}
+
+void SpatialGrid::reset(long w, long h, long d) {
+    extent = {w, h, d};
+
+    // Pick a near-cubic cell so a long container gets more cells along its length
+    double volume = std::max(1.0, static_cast<double>(w)) *
+                    std::max(1.0, static_cast<double>(h)) *
+                    std::max(1.0, static_cast<double>(d));
+    long side = std::max(1L, static_cast<long>(std::ceil(std::cbrt(volume / TARGET_CELL_COUNT))));
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        cell_size[axis] = side;
+        cell_count[axis] = static_cast<int>(std::max(1L, (extent[axis] + side - 1) / side));
+    }
+    clear();
+}
+
+void SpatialGrid::clear() {
+    cells.clear();
+    flat.clear();
+    boxes.clear();
+    first_cells.clear();
+    entry_count = 0;
+}
+
+bool SpatialGrid::covers(long w, long h, long d) const {
+    return extent[0] == w && extent[1] == h && extent[2] == d;
+}
+
+std::size_t SpatialGrid::size() const {
+    return entry_count;
+}
+
+void SpatialGrid::cellRange(const GridBox& box, std::array<int, 3>& lo, std::array<int, 3>& hi) const {
+    // Coordinates outside the bin are clamped onto the border cells, which
+    // keeps overlapping boxes on overlapping cell ranges
+    for (size_t axis = 0; axis < 3; ++axis) {
+        long last = cell_count[axis] - 1;
+        long first_cell = std::clamp(box.min[axis] / cell_size[axis], 0L, last);
+        long last_cell = std::clamp((box.max[axis] - 1) / cell_size[axis], first_cell, last);
+        lo[axis] = static_cast<int>(first_cell);
+        hi[axis] = static_cast<int>(last_cell);
+    }
+}
+
+std::size_t SpatialGrid::cellIndex(int x, int y, int z) const {
+    return (static_cast<std::size_t>(x) * cell_count[1] + y) * cell_count[2] + z;
+}
+
+const GridBox& SpatialGrid::boxOf(uint32_t id) const {
+    return boxes[id];
+}
+
+void SpatialGrid::insert(uint32_t id, const GridBox& box) {
+    if (boxes.size() <= id) {
+        boxes.resize(id + 1);
+        first_cells.resize(id + 1);
+    }
+    boxes[id] = box;
+    ++entry_count;
+
+    if (box.max[0] <= box.min[0] || box.max[1] <= box.min[1] || box.max[2] <= box.min[2]) {
+        flat.push_back(id);
+        return;
+    }
+
+    if (cells.empty()) {
+        cells.resize(static_cast<std::size_t>(cell_count[0]) * cell_count[1] * cell_count[2]);
+    }
+
+    std::array<int, 3> lo, hi;
+    cellRange(box, lo, hi);
+    first_cells[id] = lo;
+    for (int x = lo[0]; x <= hi[0]; ++x) {
+        for (int y = lo[1]; y <= hi[1]; ++y) {
+            for (int z = lo[2]; z <= hi[2]; ++z) {
+                cells[cellIndex(x, y, z)].push_back(id);
+            }
+        }
+    }
+}
+
+void SpatialGrid::eraseFrom(std::vector<uint32_t>& bucket, uint32_t id) {
+    // Entries are usually removed in reverse insertion order, so search from the back
+    auto it = std::find(bucket.rbegin(), bucket.rend(), id);
+    if (it != bucket.rend()) {
+        bucket.erase(std::next(it).base());
+    }
+}
+
+void SpatialGrid::remove(uint32_t id) {
+    if (entry_count == 0 || id >= boxes.size()) {
+        return;
+    }
+    --entry_count;
+
+    const GridBox& box = boxes[id];
+    if (box.max[0] <= box.min[0] || box.max[1] <= box.min[1] || box.max[2] <= box.min[2]) {
+        eraseFrom(flat, id);
+        return;
+    }
+    if (cells.empty()) {
+        return;
+    }
+
+    std::array<int, 3> lo, hi;
+    cellRange(box, lo, hi);
+    for (int x = lo[0]; x <= hi[0]; ++x) {
+        for (int y = lo[1]; y <= hi[1]; ++y) {
+            for (int z = lo[2]; z <= hi[2]; ++z) {
+                eraseFrom(cells[cellIndex(x, y, z)], id);
+            }
+        }
+    }
+}
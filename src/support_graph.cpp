@@ -0,0 +1,142 @@
+#include "support_graph.h"
+#include <algorithm>
+#include <limits>
+
+SupportGraph::SupportGraph() : count(0) {}
+
+void SupportGraph::clear() {
+    count = 0;
+}
+
+std::size_t SupportGraph::size() const {
+    return count;
+}
+
+const std::vector<SupportEdge>& SupportGraph::above(std::size_t index) const {
+    return nodes[index].above;
+}
+
+const std::vector<SupportEdge>& SupportGraph::below(std::size_t index) const {
+    return nodes[index].below;
+}
+
+float SupportGraph::loadAbove(std::size_t index) const {
+    return nodes[index].load;
+}
+
+long SupportGraph::topAbove(std::size_t index) const {
+    return nodes[index].top;
+}
+
+std::size_t SupportGraph::layersAbove(std::size_t index) const {
+    return nodes[index].layers.size();
+}
+
+void SupportGraph::link(const PlacedBoxes& boxes, uint32_t bottom, uint32_t top) {
+    if (boxes.min_y[top] < boxes.max_y[bottom]) {
+        return;
+    }
+    float overlap = boxes.baseOverlap(bottom, boxes.box(top));
+    float bottom_area = static_cast<float>(boxes.baseArea(bottom));
+    if (overlap <= 0.0f && bottom_area != 0.0f) {
+        return;
+    }
+
+    bool resting = overlap >= RESTING_SHARE * bottom_area;
+    nodes[bottom].above.push_back({top, overlap, resting});
+    nodes[top].below.push_back({bottom, overlap, resting});
+    if (!resting) {
+        return;
+    }
+
+    Node& node = nodes[bottom];
+    node.load += boxes.weight[top];
+    node.top = std::max(node.top, boxes.max_y[top]);
+    auto layer = std::lower_bound(node.layers.begin(), node.layers.end(), std::make_pair(boxes.min_y[top], 0u));
+    if (layer != node.layers.end() && layer->first == boxes.min_y[top]) {
+        ++layer->second;
+    } else {
+        node.layers.insert(layer, {boxes.min_y[top], 1u});
+    }
+}
+
+void SupportGraph::unlinkResting(const PlacedBoxes& boxes, uint32_t bottom, uint32_t top) {
+    Node& node = nodes[bottom];
+    auto layer = std::lower_bound(node.layers.begin(), node.layers.end(), std::make_pair(boxes.min_y[top], 0u));
+    if (--layer->second == 0) {
+        node.layers.erase(layer);
+    }
+
+    // Re-add the remaining loads in link order so the sum matches a fresh build
+    node.load = 0.0f;
+    node.top = 0;
+    for (const SupportEdge& edge : node.above) {
+        if (edge.resting) {
+            node.load += boxes.weight[edge.index];
+            node.top = std::max(node.top, boxes.max_y[edge.index]);
+        }
+    }
+}
+
+void SupportGraph::push(const PlacedBoxes& boxes, const SpatialGrid& grid) {
+    uint32_t index = static_cast<uint32_t>(count++);
+    if (nodes.size() < count) {
+        nodes.emplace_back();
+    }
+    Node& node = nodes[index];
+    node.above.clear();
+    node.below.clear();
+    node.layers.clear();
+    node.load = 0.0f;
+    node.top = 0;
+
+    // Boxes below: anything in the column under the box, plus degenerate
+    // boxes, which the grid reports to every query
+    const GridBox box = boxes.box(index);
+    GridBox column = box;
+    column.min[1] = std::numeric_limits<long>::min();
+    column.max[1] = box.min[1];
+    grid.forEachInRegion(column, [&](uint32_t other) {
+        if (other < index) {
+            link(boxes, other, index);
+        }
+        return false;
+    });
+
+    // Boxes above. Over a zero-area footprint every higher box counts, so
+    // that case walks the earlier boxes instead of a column.
+    if (box.max[0] <= box.min[0] || box.max[2] <= box.min[2]) {
+        for (uint32_t other = 0; other < index; ++other) {
+            link(boxes, index, other);
+        }
+        return;
+    }
+    column = box;
+    column.min[1] = box.max[1];
+    column.max[1] = std::numeric_limits<long>::max();
+    grid.forEachInRegion(column, [&](uint32_t other) {
+        if (other < index) {
+            link(boxes, index, other);
+        }
+        return false;
+    });
+}
+
+void SupportGraph::pop(const PlacedBoxes& boxes) {
+    if (count == 0) {
+        return;
+    }
+    uint32_t index = static_cast<uint32_t>(--count);
+    Node& node = nodes[index];
+
+    // The latest box was linked last, so its edges sit at the back of every neighbour's list
+    for (const SupportEdge& edge : node.below) {
+        nodes[edge.index].above.pop_back();
+        if (edge.resting) {
+            unlinkResting(boxes, edge.index, index);
+        }
+    }
+    for (const SupportEdge& edge : node.above) {
+        nodes[edge.index].below.pop_back();
+    }
+}
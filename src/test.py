@@ -1,4 +1,5 @@
 import unittest
+import numpy as np
 import pybinding
 
 class TestPybinding(unittest.TestCase):
@@ -74,5 +75,77 @@ class TestPybinding(unittest.TestCase):
                 packer.pack()
                 self.assertTrue(test_data["expectation"](packer))
 
+    def test_bin_totals(self):
+        bin_ = pybinding.Bin("Bin", 100, 100, 100)
+        item_a = pybinding.Item("A", 20, 10, 40, [pybinding.RotationType.whd], "red", 5.0)
+        item_b = pybinding.Item("B", 30, 20, 10, [pybinding.RotationType.whd], "red", 15.0)
+        self.assertTrue(bin_.put_item(item_a, (0, 0, 0)))
+        self.assertTrue(bin_.put_item(item_b, (20, 0, 0)))
+        self.assertEqual(bin_.get_total_weight(), 20.0)
+        self.assertEqual(bin_.get_used_volume(), 14000)
+        self.assertEqual(list(bin_.get_max_occupied()), [50, 20, 40])
+        self.assertAlmostEqual(bin_.get_fill_ratio(), 0.014)
+
+    def test_pack_arrays(self):
+        bin_dims = np.array([[100, 100, 100]])
+        item_dims = np.array([[50, 100, 100], [50, 100, 100], [100, 100, 100]])
+        rotation_mask = np.full(3, 1 << int(pybinding.RotationType.whd), dtype=np.uint8)
+        result = pybinding.pack_arrays(pybinding.Packer(), bin_dims, item_dims, rotation_mask=rotation_mask)
+        self.assertEqual(list(result.dtype.names), ["item", "bin", "x", "y", "z", "rotation"])
+        self.assertEqual(list(result["item"]), [0, 1, 2])
+        self.assertEqual(list(result["bin"]), [-1, -1, 0])
+        self.assertEqual((result["x"][2], result["y"][2], result["z"][2]), (0, 0, 0))
+
+    def test_repack(self):
+        packer = pybinding.Packer()
+        packer.add_bin(pybinding.Bin('Box', 100, 100, 100))
+        for i in range(4):
+            packer.add_item(pybinding.Item('Half %d' % i, 50, 100, 100, [pybinding.RotationType.whd]))
+        packer.pack()
+        previous = packer.get_result()
+        delta = pybinding.OrderDelta()
+        delta.removed = [previous.placements[0].item]
+        delta.added = [pybinding.Item('Quarter', 50, 50, 100, [pybinding.RotationType.whd])]
+        self.assertTrue(packer.repack(previous, delta))
+        self.assertEqual(len(packer.get_result().placements), 2)
+        self.assertEqual(len(packer.get_unfit_items()), 2)
+
+    def test_place_next(self):
+        packer = pybinding.Packer()
+        packer.add_bin(pybinding.Bin('Box', 100, 100, 100))
+        placements = [packer.place_next(pybinding.Item('Cube %d' % i, 50, 50, 50)) for i in range(9)]
+        self.assertEqual(sum(p.bin is not None for p in placements), 8)
+        self.assertEqual(len(packer.get_unfit_items()), 1)
+        self.assertEqual(packer.flush_online(), [])
+
+    def test_improve_packing(self):
+        packer = pybinding.Packer()
+        packer.add_bin(pybinding.Bin('Small', 10, 10, 10))
+        packer.add_bin(pybinding.Bin('Large', 20, 10, 10))
+        packer.add_item(pybinding.Item('Left', 10, 10, 10))
+        packer.add_item(pybinding.Item('Right', 10, 10, 10))
+        packer.pack()
+        options = pybinding.ImproveOptions()
+        options.objective = pybinding.PortfolioObjective.bins_used
+        result = pybinding.improve_packing(packer, options)
+        self.assertEqual((result.bins_used_before, result.bins_used_after), (2, 1))
+        self.assertEqual(len(packer.get_unfit_items()), 0)
+
+    def test_pack_brkga(self):
+        packer = pybinding.Packer()
+        packer.add_bin(pybinding.Bin('Box', 100, 100, 100))
+        for i in range(12):
+            packer.add_item(pybinding.Item('Box %d' % i, 30 + i, 40, 50 - i))
+        options = pybinding.BrkgaOptions()
+        options.population = 8
+        options.generations = 3
+        options.threads = 2
+        result = pybinding.pack_brkga(packer, options)
+        self.assertEqual(len(result.log), result.generations + 1)
+        self.assertEqual(len(result.best_keys), 24)
+        best = [line.best_packed_volume for line in result.log]
+        self.assertEqual(best, sorted(best))
+        self.assertEqual(len(packer.get_unfit_items()) + sum(len(b.get_items()) for b in packer.bins), 12)
+
 if __name__ == "__main__":
     unittest.main()
\ No newline at end of file
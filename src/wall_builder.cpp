@@ -0,0 +1,153 @@
+#include "wall_builder.h"
+#include <algorithm>
+#include <utility>
+
+// Raster points beyond this many (width x height) fall back to plain blocks
+const std::size_t MAX_PATTERN_STATES = 16384;
+
+// Lengths i * a + j * b no longer than limit, ascending, starting at 0
+static std::vector<long> normalLengths(long limit, long a, long b) {
+    std::vector<bool> reachable(static_cast<std::size_t>(limit) + 1, false);
+    std::vector<long> lengths;
+    for (long length = 0; length <= limit; ++length) {
+        reachable[length] = length == 0 || (length >= a && reachable[length - a]) || (length >= b && reachable[length - b]);
+        if (reachable[length]) {
+            lengths.push_back(length);
+        }
+    }
+    return lengths;
+}
+
+// Index of the longest normal length no longer than length
+static std::size_t floorIndex(const std::vector<long>& lengths, long length) {
+    return static_cast<std::size_t>(std::upper_bound(lengths.begin(), lengths.end(), length) - lengths.begin()) - 1;
+}
+
+namespace {
+
+enum class Cut { BLOCK, TURNED_BLOCK, VERTICAL, HORIZONTAL };
+
+struct PatternState {
+    long count = 0;
+    Cut cut = Cut::BLOCK;
+    std::size_t at = 0;  // cut position, an index into the cut axis' lengths
+};
+
+class PatternSolver {
+public:
+    PatternSolver(std::vector<long> xs, std::vector<long> ys, long a, long b, bool turn)
+        : a(a), b(b), turn(turn), xs(std::move(xs)), ys(std::move(ys)), states(this->xs.size() * this->ys.size()) {
+        // Sub-rectangles only shrink, so fill in order of growing width, then height
+        for (std::size_t i = 0; i < this->xs.size(); ++i) {
+            for (std::size_t j = 0; j < this->ys.size(); ++j) {
+                solve(i, j);
+            }
+        }
+    }
+
+    void emit(std::size_t i, std::size_t j, long x0, long y0, std::vector<FaceCell>& cells) const {
+        const PatternState& s = state(i, j);
+        if (s.count == 0) {
+            return;
+        }
+        switch (s.cut) {
+            case Cut::BLOCK:
+            case Cut::TURNED_BLOCK: {
+                const bool turned = s.cut == Cut::TURNED_BLOCK;
+                const long w = turned ? b : a;
+                const long h = turned ? a : b;
+                for (long y = 0; y + h <= ys[j]; y += h) {
+                    for (long x = 0; x + w <= xs[i]; x += w) {
+                        cells.push_back({x0 + x, y0 + y, turned});
+                    }
+                }
+                break;
+            }
+            case Cut::VERTICAL:
+                emit(s.at, j, x0, y0, cells);
+                emit(floorIndex(xs, xs[i] - xs[s.at]), j, x0 + xs[s.at], y0, cells);
+                break;
+            case Cut::HORIZONTAL:
+                emit(i, s.at, x0, y0, cells);
+                emit(i, floorIndex(ys, ys[j] - ys[s.at]), x0, y0 + ys[s.at], cells);
+                break;
+        }
+    }
+
+private:
+    const PatternState& state(std::size_t i, std::size_t j) const { return states[i * ys.size() + j]; }
+
+    void solve(std::size_t i, std::size_t j) {
+        const long w = xs[i];
+        const long h = ys[j];
+        PatternState best;
+        best.count = (w / a) * (h / b);
+        if (turn && (w / b) * (h / a) > best.count) {
+            best.count = (w / b) * (h / a);
+            best.cut = Cut::TURNED_BLOCK;
+        }
+        // A cut and its mirror give the same count, so only cut up to half way
+        for (std::size_t k = 1; k < i && 2 * xs[k] <= w; ++k) {
+            long count = state(k, j).count + state(floorIndex(xs, w - xs[k]), j).count;
+            if (count > best.count) {
+                best = {count, Cut::VERTICAL, k};
+            }
+        }
+        for (std::size_t k = 1; k < j && 2 * ys[k] <= h; ++k) {
+            long count = state(i, k).count + state(i, floorIndex(ys, h - ys[k])).count;
+            if (count > best.count) {
+                best = {count, Cut::HORIZONTAL, k};
+            }
+        }
+        states[i * ys.size() + j] = best;
+    }
+
+    long a;
+    long b;
+    bool turn;
+    std::vector<long> xs;
+    std::vector<long> ys;
+    std::vector<PatternState> states;
+};
+
+}  // namespace
+
+std::vector<FaceCell> guillotinePattern(long width, long height, long a, long b, bool turn) {
+    std::vector<FaceCell> cells;
+    if (a <= 0 || b <= 0 || width <= 0 || height <= 0) {
+        return cells;
+    }
+
+    std::vector<long> xs = normalLengths(width, a, b);
+    std::vector<long> ys = normalLengths(height, a, b);
+    if (xs.size() * ys.size() <= MAX_PATTERN_STATES) {
+        const std::size_t i = xs.size() - 1;
+        const std::size_t j = ys.size() - 1;
+        PatternSolver solver(std::move(xs), std::move(ys), a, b, turn);
+        solver.emit(i, j, 0, 0, cells);
+    } else {
+        // Too many cut positions to try; stack one block each way and keep the larger
+        const bool turned = turn && (width / b) * (height / a) > (width / a) * (height / b);
+        const long w = turned ? b : a;
+        const long h = turned ? a : b;
+        for (long y = 0; y + h <= height; y += h) {
+            for (long x = 0; x + w <= width; x += w) {
+                cells.push_back({x, y, turned});
+            }
+        }
+    }
+
+    std::sort(cells.begin(), cells.end(), [](const FaceCell& p, const FaceCell& q) {
+        return p.y != q.y ? p.y < q.y : p.x < q.x;
+    });
+    return cells;
+}
+
+const std::vector<FaceCell>& FacePatternCache::lookup(long width, long height, long a, long b, bool turn) {
+    auto key = std::make_tuple(width, height, a, b, turn);
+    auto it = patterns.find(key);
+    if (it == patterns.end()) {
+        it = patterns.emplace(key, guillotinePattern(width, height, a, b, turn)).first;
+    }
+    return it->second;
+}
@@ -0,0 +1,86 @@
+#include "work_pool.h"
+#include <algorithm>
+
+WorkPool::WorkPool(std::size_t workers) : next_queue(0), pending(0), stopping(false) {
+    workers = std::max<std::size_t>(1, workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < workers; ++i) {
+        threads.emplace_back(&WorkPool::run, this, i);
+    }
+}
+
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::size_t WorkPool::size() const {
+    return queues.size();
+}
+
+void WorkPool::submit(Task task) {
+    Queue& queue = *queues[next_queue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+bool WorkPool::popOwn(std::size_t worker, Task& task) {
+    Queue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkPool::steal(std::size_t worker, Task& task) {
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue& queue = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkPool::run(std::size_t worker) {
+    Task task;
+    while (true) {
+        {
+            // Sleep until some task is queued; drain what is left before stopping
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait(lock, [this] { return pending > 0 || stopping; });
+            if (pending == 0) {
+                return;
+            }
+            --pending;
+        }
+
+        // A task is reserved for us by the count above, so one of the deques holds it
+        while (!popOwn(worker, task) && !steal(worker, task)) {
+            std::this_thread::yield();
+        }
+        task(worker);
+        task = nullptr;
+    }
+}